@@ -6,10 +6,74 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <initializer_list>
 #include <numeric>
 #include <limits>
 #include <vector>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace internal {
+    struct PowerPeak {
+        PowerPeak(double e, double p) : elevation(e), power(p) {}
+        double elevation;
+        double power;
+    };
+
+    //! Tracks what evaluate needs from the peaks without storing them.
+    class PeakSummary {
+    public:
+        explicit PeakSummary(double steering) : steering_angle(steering) {}
+
+        void add(PowerPeak const& peak)
+        {
+            const double distance = std::abs(peak.elevation - steering_angle);
+            if (count == 0 || peak.power > top.power) {
+                second_power = top.power;
+                top = peak;
+                top_id = count;
+            }
+            else if (count == 1 || peak.power > second_power)
+                second_power = peak.power;
+
+            if (count == 0 || distance < nearest[0].distance) {
+                nearest[1] = nearest[0];
+                nearest[0] = {distance, count};
+            }
+            else if (count == 1 || distance < nearest[1].distance)
+                nearest[1] = {distance, count};
+            ++count;
+        }
+
+        //! Peak SLL, as defined by AntennaArray::evaluate.
+        double side_lobe_level() const
+        {
+            //No side-lobes case
+            if (count < 2) return std::numeric_limits<double>::min();
+            //The main lobe must be the highest peak nearest the steering angle
+            const auto& other = nearest[nearest[0].id == top_id ? 1 : 0];
+            if (other.distance < std::abs(top.elevation - steering_angle))
+                return top.power;
+            return second_power;
+        }
+    private:
+        struct Nearest {
+            double distance;
+            std::size_t id;
+        };
+
+        double steering_angle;
+        std::size_t count = 0;
+        PowerPeak top{0.0, 0.0};
+        std::size_t top_id = 0;
+        double second_power = 0.0;
+        Nearest nearest[2] = {};
+    };
+}
+
 struct Bounds
 {
     double min;
@@ -27,8 +91,11 @@ public:
     * @brief Construct an antenna design problem.
     * @param n_ant Number of antennae in our array.
     * @param steering_ang Desired direction of the main beam in degrees.
+    * @param tolerance Permitted error of the peak SLL in dB. Zero samples every
+    * 0.01 degrees, otherwise a coarse sweep is made and each peak it brackets is
+    * refined until its power is known to about this tolerance.
     */
-    AntennaArray(unsigned int n_ant,double steering_ang = 90);
+    AntennaArray(unsigned int n_ant,double steering_ang = 90,double tolerance = 0);
 
     std::size_t count() const noexcept;
 
@@ -57,13 +124,77 @@ public:
     * @param design A valid antenna array design.
     */
     template<typename RandomIt>
-    constexpr double evaluate(RandomIt first, RandomIt last);
+    double evaluate(RandomIt first, RandomIt last);
+    /*!
+    * @brief Evaluate count designs at once, sharing each block of elevation
+    * phases between them.
+    * @param designs Design i starts at designs[i * stride].
+    * @param out Receives the peak SSL of each design.
+    */
+    void evaluate_batch(
+        const double* designs,
+        std::size_t stride,
+        std::size_t count,
+        double* out);
 private:
+    //! Samples evaluated together, small enough to stay in the L1 cache.
+    static constexpr std::size_t block_size = 256;
+
+    //! Peak detection state carried from one block of samples to the next.
+    struct Scan {
+        explicit Scan(double steering = 0.0) : summary(steering) {}
+        internal::PeakSummary summary;
+        double prev = std::numeric_limits<double>::min();
+        double current = 0.0;
+    };
+
     const unsigned int n_antennae;
     const double steering_angle;
+    const double tolerance;
+    //! The sampled elevations in degrees, ending with 180.
+    std::vector<double> elevations;
+    //! 2 * pi * (cos(elevation) - cos(steering)) for each sampled elevation.
+    std::vector<double> phases;
 
     template<typename RandomIt>
-    constexpr double array_factor(RandomIt first, RandomIt last, double);
+    double array_factor(RandomIt first, RandomIt last, double);
+
+    /*!
+    * @brief Find the peaks among the powers of the samples [from, from + count).
+    * A sample is a peak when it is no lower than both neighbours, and the
+    * final sample always is.
+    */
+    template<typename RandomIt>
+    void scan(
+        RandomIt first,
+        RandomIt last,
+        std::size_t from,
+        std::size_t count,
+        const double* power,
+        Scan& state);
+
+    /*!
+    * @brief Refine the peak at a sample no lower than its neighbours by
+    * golden-section search between them.
+    * @param power The powers at sample - 1, sample and sample + 1.
+    */
+    template<typename RandomIt>
+    internal::PowerPeak refine_peak(
+        RandomIt first,
+        RandomIt last,
+        std::size_t sample,
+        const double (&power)[3]);
+
+    /*!
+    * @brief Power of the design at the sampled elevations [from, from + count).
+    */
+    template<typename RandomIt>
+    void array_factors(
+        RandomIt first,
+        RandomIt last,
+        std::size_t from,
+        std::size_t count,
+        double* power) const;
 };
 
 #include <iostream>
@@ -89,51 +220,167 @@ constexpr bool AntennaArray::is_valid(RandomIt first, RandomIt last) const
 }
 
 namespace internal {
-    struct PowerPeak {
-        PowerPeak(double e, double p) : elevation(e), power(p) {}
-        double elevation;
-        double power;
-    };
+#ifdef __AVX2__
+    //! Cephes style cosine of four lanes, accurate to about 1 ulp.
+    inline __m256d cos4(__m256d x)
+    {
+        const auto floor = [](__m256d v) {
+            return _mm256_round_pd(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        };
+        const auto poly = [](__m256d z, std::initializer_list<double> c) {
+            auto it = c.begin();
+            auto r = _mm256_set1_pd(*it);
+            while (++it != c.end())
+                r = _mm256_add_pd(_mm256_mul_pd(r, z), _mm256_set1_pd(*it));
+            return r;
+        };
+        const auto sign_mask = _mm256_set1_pd(-0.0);
+        x = _mm256_andnot_pd(sign_mask, x);
+
+        //Octant rounded up to even, and its value modulo 8
+        auto y = floor(_mm256_mul_pd(x, _mm256_set1_pd(4 / M_PI)));
+        const auto half = floor(_mm256_mul_pd(y, _mm256_set1_pd(0.5)));
+        y = _mm256_add_pd(y, _mm256_sub_pd(y, _mm256_add_pd(half, half)));
+        const auto octant = _mm256_sub_pd(
+            y,
+            _mm256_mul_pd(floor(_mm256_mul_pd(y, _mm256_set1_pd(0.125))), _mm256_set1_pd(8.0)));
+
+        //Extended precision reduction to [-pi/4, pi/4]
+        auto z = _mm256_sub_pd(x, _mm256_mul_pd(y, _mm256_set1_pd(7.85398125648498535156E-1)));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, _mm256_set1_pd(3.77489470793079817668E-8)));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, _mm256_set1_pd(2.69515142907905952645E-15)));
+        const auto zz = _mm256_mul_pd(z, z);
+
+        const auto sin_part = _mm256_add_pd(z, _mm256_mul_pd(
+            _mm256_mul_pd(z, zz),
+            poly(zz, {1.58962301576546568060E-10, -2.50507477628578072866E-8,
+                2.75573136213857245213E-6, -1.98412698295895385996E-4,
+                8.33333333332211858878E-3, -1.66666666666666307295E-1})));
+        const auto cos_part = _mm256_add_pd(
+            _mm256_sub_pd(_mm256_set1_pd(1.0), _mm256_mul_pd(zz, _mm256_set1_pd(0.5))),
+            _mm256_mul_pd(
+                _mm256_mul_pd(zz, zz),
+                poly(zz, {-1.13585365213876817300E-11, 2.08757008419747316778E-9,
+                    -2.75573141792967388112E-7, 2.48015872888517045348E-5,
+                    -1.38888888888730564116E-3, 4.16666666666665929218E-2})));
+
+        const auto is = [&](double v) {
+            return _mm256_cmp_pd(octant, _mm256_set1_pd(v), _CMP_EQ_OQ);
+        };
+        const auto result = _mm256_blendv_pd(cos_part, sin_part, _mm256_or_pd(is(2), is(6)));
+        return _mm256_xor_pd(result, _mm256_and_pd(_mm256_or_pd(is(2), is(4)), sign_mask));
+    }
+#endif
 }
 
 template<typename RandomIt>
-constexpr double AntennaArray::evaluate(RandomIt first, RandomIt last)
+double AntennaArray::evaluate(RandomIt first, RandomIt last)
 {
     assert(std::distance(first, last) == n_antennae
          && "AntennaArray::evaluate called on design of the wrong size.");
     if (!is_valid(first, last)) return std::numeric_limits<double>::max();
 
-    std::vector<internal::PowerPeak> peaks;
+    double power[block_size];
+    Scan state(steering_angle);
+    for (std::size_t from = 0; from < elevations.size(); from += block_size) {
+        const std::size_t count = std::min(block_size, elevations.size() - from);
+        array_factors(first, last, from, count, power);
+        scan(first, last, from, count, power, state);
+    }
+
+    return state.summary.side_lobe_level();
+}
+
+template<typename RandomIt>
+void AntennaArray::scan(
+    RandomIt first,
+    RandomIt last,
+    std::size_t from,
+    std::size_t count,
+    const double* power,
+    Scan& state)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t sample = from + i;
+        if (sample == 0) {
+            state.current = power[i];
+            continue;
+        }
+        if (sample + 1 == elevations.size()) {
+            state.summary.add({elevations[sample], power[i]});
+            continue;
+        }
+        if (state.current >= state.prev && state.current >= power[i])
+            state.summary.add(tolerance > 0 && sample > 1
+                ? refine_peak(first, last, sample - 1, {state.prev, state.current, power[i]})
+                : internal::PowerPeak{elevations[sample - 1], state.current});
+        state.prev = state.current;
+        state.current = power[i];
+    }
+}
 
-    internal::PowerPeak prev(0.0, std::numeric_limits<double>::min());
-    internal::PowerPeak current(0.0, array_factor(first, last, 0.0));
-    for (double elevation = 0.01; elevation <= 180.0; elevation += 0.01) {
-        internal::PowerPeak next(elevation, array_factor(first, last, elevation));
-        if (current.power >= prev.power && current.power >= next.power)
-            peaks.push_back(current);
-        prev = current;
-        current = next;
+template<typename RandomIt>
+void AntennaArray::array_factors(
+    RandomIt first,
+    RandomIt last,
+    std::size_t from,
+    std::size_t count,
+    double* power) const
+{
+    const double* phase = phases.data() + from;
+    std::fill_n(power, count, 0.0);
+    for (; first != last; ++first) {
+        const double x = *first;
+        std::size_t i = 0;
+#ifdef __AVX2__
+        const auto position = _mm256_set1_pd(x);
+        for (; i + 4 <= count; i += 4)
+            _mm256_storeu_pd(power + i, _mm256_add_pd(
+                _mm256_loadu_pd(power + i),
+                internal::cos4(_mm256_mul_pd(position, _mm256_loadu_pd(phase + i)))));
+#endif
+        for (; i < count; ++i)
+            power[i] += cos(x * phase[i]);
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+        power[i] = 20 * log(fabs(power[i]));
+}
+
+template<typename RandomIt>
+internal::PowerPeak AntennaArray::refine_peak(
+    RandomIt first,
+    RandomIt last,
+    std::size_t sample,
+    const double (&power)[3])
+{
+    const double golden = 0.5 * (3 - std::sqrt(5.0));
+    internal::PowerPeak low{elevations[sample - 1], power[0]};
+    internal::PowerPeak peak{elevations[sample], power[1]};
+    internal::PowerPeak high{elevations[sample + 1], power[2]};
+
+    //The peak lies between low and high, so once the bracket is flat to within
+    //the tolerance the best point found is close enough.
+    while (peak.power - std::min(low.power, high.power) > tolerance
+        && high.elevation - low.elevation > 1e-9)
+    {
+        const bool upper = high.elevation - peak.elevation > peak.elevation - low.elevation;
+        const double elevation = upper
+            ? peak.elevation + golden * (high.elevation - peak.elevation)
+            : peak.elevation - golden * (peak.elevation - low.elevation);
+        const internal::PowerPeak probe{elevation, array_factor(first, last, elevation)};
+        if (probe.power >= peak.power) {
+            (upper ? low : high) = peak;
+            peak = probe;
+        }
+        else
+            (upper ? high : low) = probe;
     }
-    peaks.push_back({ 180.0,array_factor(first, last,180.0) });
-
-    std::sort(
-        std::begin(peaks),
-        std::end(peaks),
-        [](auto&& l, auto&& r) {return l.power > r.power; }
-    );
-
-    //No side-lobes case
-    if (peaks.size() < 2) return std::numeric_limits<double>::min();
-    //Filter out main lobe and then return highest lobe level
-    const double distance_from_steering = abs(peaks[0].elevation - steering_angle);
-    for (size_t i = 1; i < peaks.size(); ++i)
-        if (abs(peaks[i].elevation - steering_angle) < distance_from_steering)
-            return peaks[0].power;
-    return peaks[1].power;
+    return peak;
 }
 
 template<typename RandomIt>
-constexpr double AntennaArray::array_factor(RandomIt first, RandomIt last, double elevation)
+double AntennaArray::array_factor(RandomIt first, RandomIt last, double elevation)
 {
     double steering = 2 * M_PI * steering_angle / 360;
     elevation = 2 * M_PI * elevation / 360;
@@ -0,0 +1,218 @@
+#ifndef CS3910__CANDIDATES_H_
+#define CS3910__CANDIDATES_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// The k nearest neighbours of every node, nearest first.
+class CandidateList final
+{
+public:
+    using value_type = std::uint32_t;
+
+    CandidateList() noexcept;
+
+    // Build from a range of nodes with x and y members. k is clamped to the
+    // number of other nodes.
+    template<typename ForwardIt>
+    CandidateList(ForwardIt first, ForwardIt last, std::size_t k);
+
+    // View the first size of every stride values of data, kept alive by
+    // owner, such as the lists of a packed problem file.
+    CandidateList(
+        std::shared_ptr<void const> owner,
+        value_type const* data,
+        std::size_t count,
+        std::size_t size,
+        std::size_t stride) noexcept;
+
+    value_type const* operator()(std::size_t node) const noexcept;
+
+    constexpr std::size_t Count() const noexcept;
+
+    constexpr std::size_t Size() const noexcept;
+
+    constexpr bool Empty() const noexcept;
+private:
+    std::shared_ptr<value_type const[]> data_;
+
+    std::size_t count_;
+
+    std::size_t size_;
+
+    std::size_t stride_;
+};
+
+inline CandidateList::CandidateList() noexcept
+    : data_{}
+    , count_{}
+    , size_{}
+    , stride_{}
+{
+}
+
+inline CandidateList::CandidateList(
+    std::shared_ptr<void const> owner,
+    value_type const* data,
+    std::size_t count,
+    std::size_t size,
+    std::size_t stride)
+    noexcept
+    : data_{std::move(owner), data}
+    , count_{count}
+    , size_{size}
+    , stride_{stride}
+{
+    assert(size <= stride);
+}
+
+template<typename ForwardIt>
+CandidateList::CandidateList(ForwardIt first, ForwardIt last, std::size_t k)
+    : data_{}
+    , count_{static_cast<std::size_t>(std::distance(first, last))}
+    , size_{count_ == 0 ? 0 : std::min(k, count_ - 1)}
+    , stride_{size_}
+{
+    assert(count_ <= std::numeric_limits<value_type>::max());
+    if (size_ == 0)
+        return;
+    auto data{ std::make_unique<value_type[]>(count_ * size_) };
+
+    std::vector<double> xs{};
+    std::vector<double> ys{};
+    xs.reserve(count_);
+    ys.reserve(count_);
+    for (auto it = first; it != last; ++it)
+    {
+        xs.push_back(it->x);
+        ys.push_back(it->y);
+    }
+
+    // Bucket the nodes into a grid of square cells holding about two nodes
+    // each, which stays sparse even when the nodes lie along a line.
+    auto const [MinX, MaxX] = std::minmax_element(xs.begin(), xs.end());
+    auto const [MinY, MaxY] = std::minmax_element(ys.begin(), ys.end());
+    auto const SpanX{ *MaxX - *MinX };
+    auto const SpanY{ *MaxY - *MinY };
+    auto const Size{ std::max({
+        std::sqrt(SpanX * SpanY * 2.0 / count_),
+        std::max(SpanX, SpanY) * 2.0 / count_,
+        1e-9 }) };
+    auto const Cells = [=](double span)
+    {
+        return std::max<std::ptrdiff_t>(1, static_cast<std::ptrdiff_t>(std::ceil(span / Size)));
+    };
+    auto const GridX{ Cells(SpanX) };
+    auto const GridY{ Cells(SpanY) };
+    auto const Cell = [=](double offset, std::ptrdiff_t grid)
+    {
+        return std::min(grid - 1, static_cast<std::ptrdiff_t>(offset / Size));
+    };
+
+    std::vector<std::size_t> cellOf(count_);
+    std::vector<std::size_t> cellStart(GridX * GridY + 1);
+    for (std::size_t i{}; i < count_; ++i)
+    {
+        cellOf[i] = Cell(xs[i] - *MinX, GridX) + GridX * Cell(ys[i] - *MinY, GridY);
+        ++cellStart[cellOf[i] + 1];
+    }
+    std::partial_sum(cellStart.begin(), cellStart.end(), cellStart.begin());
+
+    std::vector<value_type> cells(count_);
+    {
+        auto next{ cellStart };
+        for (std::size_t i{}; i < count_; ++i)
+            cells[next[cellOf[i]]++] = static_cast<value_type>(i);
+    }
+
+    // Visit rings of cells around the node's own cell until no unvisited cell
+    // can hold a node nearer than the k-th best found so far.
+    struct Neighbour
+    {
+        double distance; // Squared
+        value_type node;
+    };
+    std::vector<Neighbour> best(size_);
+    for (std::size_t const i : cells) // Cell order keeps the search local
+    {
+        std::size_t found{};
+        auto const Consider = [&](value_type j)
+        {
+            if (j == i)
+                return;
+            auto const Dx{ xs[i] - xs[j] };
+            auto const Dy{ ys[i] - ys[j] };
+            auto const Distance{ Dx * Dx + Dy * Dy };
+            if (found == size_ && best[found - 1].distance <= Distance)
+                return;
+            auto pos{ found < size_ ? found++ : found - 1 };
+            for (; pos != 0 && Distance < best[pos - 1].distance; --pos)
+                best[pos] = best[pos - 1];
+            best[pos] = Neighbour{Distance, j};
+        };
+
+        auto const CellX{ static_cast<std::ptrdiff_t>(cellOf[i] % GridX) };
+        auto const CellY{ static_cast<std::ptrdiff_t>(cellOf[i] / GridX) };
+        for (std::ptrdiff_t ring{}; ring < std::max(GridX, GridY); ++ring)
+        {
+            for (auto y{ std::max<std::ptrdiff_t>(0, CellY - ring) }; y <= std::min(GridY - 1, CellY + ring); ++y)
+            {
+                // Only the first and last rows of a ring are full
+                auto const Stride{ y == CellY - ring || y == CellY + ring ? 1 : 2 * ring };
+                for (auto x{ CellX - ring }; x <= CellX + ring; x += Stride)
+                {
+                    if (x < 0 || GridX <= x)
+                        continue;
+                    auto const Id{ static_cast<std::size_t>(x + GridX * y) };
+                    std::for_each(
+                        cells.begin() + cellStart[Id],
+                        cells.begin() + cellStart[Id + 1],
+                        Consider);
+                }
+            }
+
+            if (found == size_ && best[found - 1].distance <= ring * ring * Size * Size)
+                break;
+        }
+
+        std::transform(
+            best.begin(),
+            best.end(),
+            data.get() + i * size_,
+            [](auto const& n){ return n.node; });
+    }
+    data_ = std::move(data);
+}
+
+inline CandidateList::value_type const*
+CandidateList::operator()(std::size_t node) const noexcept
+{
+    assert(node < count_ && "The node must be less than the node count.");
+    return data_.get() + node * stride_;
+}
+
+constexpr std::size_t CandidateList::Count() const noexcept
+{
+    return count_;
+}
+
+constexpr std::size_t CandidateList::Size() const noexcept
+{
+    return size_;
+}
+
+constexpr bool CandidateList::Empty() const noexcept
+{
+    return size_ == 0;
+}
+
+#endif // !CS3910__CANDIDATES_H_
@@ -0,0 +1,377 @@
+#ifndef CS3910__DISTANCE_H_
+#define CS3910__DISTANCE_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// How the distance between two nodes follows from their coordinates.
+enum class Metric
+{
+    Euclidean, // Exact, as in the CSV problems
+    Euc2D, // TSPLIB EUC_2D, Euclidean rounded to the nearest integer
+    Geo, // TSPLIB GEO, x and y are latitude and longitude as DDD.MM
+    Att // TSPLIB ATT, pseudo Euclidean
+};
+
+// The distance between (x1, y1) and (x2, y2) under metric, following the
+// reference implementation of TSPLIB for its metrics. Euclidean distances use
+// sqrt rather than hypot, which is far slower and guards against overflows
+// that coordinates never come near.
+template<typename T>
+T MetricDistance(Metric metric, T x1, T y1, T x2, T y2) noexcept
+{
+    switch (metric)
+    {
+    case Metric::Euc2D:
+        return std::floor(
+            std::sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2)) + T{0.5});
+    case Metric::Geo:
+    {
+        constexpr double Pi{ 3.141592 };
+        constexpr double EarthRadius{ 6378.388 };
+        auto const Radians{ [=](double x)
+        {
+            auto const Degrees{ std::trunc(x) };
+            return Pi * (Degrees + 5.0 * (x - Degrees) / 3.0) / 180.0;
+        } };
+        auto const Latitude1{ Radians(x1) };
+        auto const Latitude2{ Radians(x2) };
+        auto const Q1{ std::cos(Radians(y1) - Radians(y2)) };
+        auto const Q2{ std::cos(Latitude1 - Latitude2) };
+        auto const Q3{ std::cos(Latitude1 + Latitude2) };
+        return static_cast<T>(std::trunc(
+            EarthRadius * std::acos(0.5 * ((1.0 + Q1) * Q2 - (1.0 - Q1) * Q3)) + 1.0));
+    }
+    case Metric::Att:
+    {
+        auto const Distance{ std::sqrt(
+            ((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2)) / T{10}) };
+        auto const Rounded{ std::floor(Distance + T{0.5}) };
+        return Rounded < Distance ? Rounded + T{1} : Rounded;
+    }
+    default:
+        return std::sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2));
+    }
+}
+
+// The distances from (x, y) to the count nodes at xs and ys under metric,
+// written to out. Integral V stores them rounded to the nearest integer, as
+// the nint of TSPLIB. The Euclidean metrics take four nodes at a time when
+// the translation unit is compiled with AVX2 enabled, see CS3910_ENABLE_AVX2.
+template<typename V>
+void DistanceRow(
+    Metric metric,
+    double x,
+    double y,
+    double const* xs,
+    double const* ys,
+    std::size_t count,
+    V* out)
+    noexcept
+{
+    std::size_t i{};
+#ifdef __AVX2__
+    if (metric == Metric::Euclidean || metric == Metric::Euc2D)
+    {
+        auto const Round{ metric == Metric::Euc2D || std::is_integral_v<V> };
+        auto const X{ _mm256_set1_pd(x) };
+        auto const Y{ _mm256_set1_pd(y) };
+        auto const Half{ _mm256_set1_pd(0.5) };
+        for (; i + 4 <= count; i += 4)
+        {
+            auto const Dx{ _mm256_sub_pd(X, _mm256_loadu_pd(xs + i)) };
+            auto const Dy{ _mm256_sub_pd(Y, _mm256_loadu_pd(ys + i)) };
+            auto distance{ _mm256_sqrt_pd(
+                _mm256_add_pd(_mm256_mul_pd(Dx, Dx), _mm256_mul_pd(Dy, Dy))) };
+            if (Round)
+                distance = _mm256_floor_pd(_mm256_add_pd(distance, Half));
+
+            if constexpr (std::is_same_v<V, double>)
+                _mm256_storeu_pd(out + i, distance);
+            else if constexpr (std::is_same_v<V, float>)
+                _mm_storeu_ps(out + i, _mm256_cvtpd_ps(distance));
+            else if constexpr (std::is_same_v<V, std::int32_t>)
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i*>(out + i),
+                    _mm256_cvttpd_epi32(distance));
+            else
+                break;
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        auto const Distance{ MetricDistance(metric, x, y, xs[i], ys[i]) };
+        if constexpr (std::is_integral_v<V>)
+            out[i] = static_cast<V>(std::floor(Distance + 0.5));
+        else
+            out[i] = static_cast<V>(Distance);
+    }
+}
+
+// Distances computed on demand from the coordinates of the nodes, so only
+// O(n) memory is needed.
+template<typename T>
+class EuclideanDistance final
+{
+public:
+    using value_type = T;
+
+    // Build from a range of nodes with x and y members.
+    template<typename ForwardIt>
+    EuclideanDistance(
+        ForwardIt first,
+        ForwardIt last,
+        Metric metric = Metric::Euclidean);
+
+    value_type operator()(std::size_t x, std::size_t y) const noexcept;
+
+    constexpr std::size_t Count() const noexcept;
+private:
+    std::unique_ptr<value_type[]> xs_;
+
+    std::unique_ptr<value_type[]> ys_;
+
+    std::size_t count_;
+
+    Metric metric_;
+};
+
+template<typename T>
+template<typename ForwardIt>
+EuclideanDistance<T>::EuclideanDistance(
+    ForwardIt first,
+    ForwardIt last,
+    Metric metric)
+    : xs_{}
+    , ys_{}
+    , count_{static_cast<std::size_t>(std::distance(first, last))}
+    , metric_{metric}
+{
+    xs_ = std::make_unique<value_type[]>(count_);
+    ys_ = std::make_unique<value_type[]>(count_);
+    for (std::size_t i{}; first != last; ++first, ++i)
+    {
+        xs_[i] = first->x;
+        ys_[i] = first->y;
+    }
+}
+
+template<typename T>
+typename EuclideanDistance<T>::value_type
+EuclideanDistance<T>::operator()(
+    std::size_t x,
+    std::size_t y)
+    const noexcept
+{
+    assert(x < count_ && "The x position must be less than the vertex count.");
+    assert(y < count_ && "The y position must be less than the vertex count.");
+    return MetricDistance(metric_, xs_[x], ys_[x], xs_[y], ys_[y]);
+}
+
+template<typename T>
+constexpr std::size_t EuclideanDistance<T>::Count() const noexcept
+{
+    return count_;
+}
+
+template<typename T>
+T Weight(EuclideanDistance<T> const& graph, std::size_t x, std::size_t y)
+{
+    return graph(x, y);
+}
+
+namespace internal
+{
+    // The most threads that may hold a slot at once
+    constexpr std::size_t THREAD_SLOTS{ 256 };
+
+    // A small number for the calling thread, held by no other running thread
+    // and handed on once the thread exits. THREAD_SLOTS when all are taken.
+    std::size_t ThreadSlot() noexcept;
+}
+
+// A bounded, direct mapped cache of the distances of another provider. The
+// cache is filled by const lookups, so every thread fills a table of its own
+// and lookups from many threads never touch the same entries. Threads beyond
+// THREAD_SLOTS go uncached.
+template<typename Graph>
+class CachedDistance final
+{
+public:
+    using value_type = typename Graph::value_type;
+
+    static constexpr std::size_t DEFAULT_CAPACITY{ std::size_t{1} << 18 };
+
+    // capacity, the entries of each thread, is rounded up to a power of two.
+    explicit CachedDistance(
+        Graph graph,
+        std::size_t capacity = DEFAULT_CAPACITY);
+
+    // Build the underlying provider from a range of nodes.
+    template<typename ForwardIt>
+    CachedDistance(
+        ForwardIt first,
+        ForwardIt last,
+        std::size_t capacity = DEFAULT_CAPACITY);
+
+    template<typename ForwardIt>
+    CachedDistance(
+        ForwardIt first,
+        ForwardIt last,
+        Metric metric,
+        std::size_t capacity = DEFAULT_CAPACITY);
+
+    value_type operator()(std::size_t x, std::size_t y) const noexcept;
+
+    constexpr std::size_t Count() const noexcept;
+private:
+    struct Entry
+    {
+        std::uint64_t key; // Zero when empty
+        value_type value;
+    };
+
+    Graph graph_;
+
+    // One per thread slot, made by the first lookup in the slot
+    std::unique_ptr<std::unique_ptr<Entry[]>[]> tables_;
+
+    std::size_t mask_;
+};
+
+namespace internal
+{
+    class ThreadSlots final
+    {
+    public:
+        std::size_t Acquire() noexcept
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            if (free_.empty())
+                return next_ < THREAD_SLOTS ? next_++ : THREAD_SLOTS;
+            auto const Slot{ free_.back() };
+            free_.pop_back();
+            return Slot;
+        }
+
+        void Release(std::size_t slot) noexcept
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            if (slot < THREAD_SLOTS)
+                free_.push_back(slot);
+        }
+    private:
+        std::mutex mutex_;
+
+        std::vector<std::size_t> free_;
+
+        std::size_t next_{};
+    };
+
+    inline ThreadSlots& Slots() noexcept
+    {
+        static ThreadSlots slots{};
+        return slots;
+    }
+
+    inline std::size_t ThreadSlot() noexcept
+    {
+        // The lock that hands a slot on orders the tables it was used for
+        thread_local struct Holder
+        {
+            std::size_t slot{ Slots().Acquire() };
+
+            ~Holder()
+            {
+                Slots().Release(slot);
+            }
+        } holder{};
+        return holder.slot;
+    }
+}
+
+template<typename Graph>
+CachedDistance<Graph>::CachedDistance(Graph graph, std::size_t capacity)
+    : graph_{std::move(graph)}
+    , tables_{std::make_unique<std::unique_ptr<Entry[]>[]>(internal::THREAD_SLOTS)}
+    , mask_{1}
+{
+    while (mask_ < capacity)
+        mask_ <<= 1;
+    --mask_;
+}
+
+template<typename Graph>
+template<typename ForwardIt>
+CachedDistance<Graph>::CachedDistance(
+    ForwardIt first,
+    ForwardIt last,
+    std::size_t capacity)
+    : CachedDistance{Graph{first, last}, capacity}
+{
+}
+
+template<typename Graph>
+template<typename ForwardIt>
+CachedDistance<Graph>::CachedDistance(
+    ForwardIt first,
+    ForwardIt last,
+    Metric metric,
+    std::size_t capacity)
+    : CachedDistance{Graph{first, last, metric}, capacity}
+{
+}
+
+template<typename Graph>
+typename CachedDistance<Graph>::value_type
+CachedDistance<Graph>::operator()(
+    std::size_t x,
+    std::size_t y)
+    const noexcept
+{
+    if (x > y)
+        std::swap(x, y);
+
+    auto const Slot{ internal::ThreadSlot() };
+    if (Slot == internal::THREAD_SLOTS)
+        return Weight(graph_, x, y);
+    auto& table{ tables_[Slot] };
+    if (!table)
+        table = std::make_unique<Entry[]>(mask_ + 1);
+
+    auto const Key{ static_cast<std::uint64_t>(x) * graph_.Count() + y + 1 };
+    auto& entry{ table[(Key * 0x9E3779B97F4A7C15ull >> 32) & mask_] };
+    if (entry.key != Key)
+        entry = Entry{Key, Weight(graph_, x, y)};
+    return entry.value;
+}
+
+template<typename Graph>
+constexpr std::size_t CachedDistance<Graph>::Count() const noexcept
+{
+    return graph_.Count();
+}
+
+template<typename Graph>
+typename Graph::value_type Weight(
+    CachedDistance<Graph> const& graph,
+    std::size_t x,
+    std::size_t y)
+{
+    return graph(x, y);
+}
+
+#endif // !CS3910__DISTANCE_H_
@@ -1,44 +1,292 @@
 #ifndef CS3910__EVOLUTION_H_
 #define CS3910__EVOLUTION_H_
 
+#include "Neighbourhood.h"
+#include "Random.h"
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
-#include <random>
+#include <memory>
+#include <numeric>
 
 template<typename RandomIt, typename RngT>
 void Opt2RandomSwap(RandomIt first, RandomIt last, RngT& rng)
 {
     auto const Length{ static_cast<std::size_t>(std::distance(first, last)) };
-    std::uniform_int_distribution<std::size_t> dis{ 0, Length - 1 };
-    std::swap(first[dis(rng)], first[dis(rng)]);
+    auto const I{ UniformIndex(rng, Length) };
+    std::swap(first[I], first[UniformIndex(rng, Length)]);
 }
 
-template<typename RandomIt>
+// Swap two random cities of the route and return the change in its cost, so
+// the caller can update the cost without walking the whole route.
+template<typename Graph, typename RandomIt, typename RngT>
+auto Opt2RandomSwap(
+    Graph const& graph,
+    RandomIt first,
+    RandomIt last,
+    RngT& rng)
+{
+    auto const Length{ static_cast<std::size_t>(std::distance(first, last)) };
+    auto const I{ UniformIndex(rng, Length) };
+    auto const J{ UniformIndex(rng, Length) };
+    auto const Delta{ SwapDelta(graph, first, last, I, J) };
+    std::swap(first[I], first[J]);
+    return Delta;
+}
+
+// Reverse a random segment of the route and return the change in its cost,
+// so the caller can update the cost without walking the whole route.
+template<typename Graph, typename RandomIt, typename RngT>
+auto Opt2RandomReverse(
+    Graph const& graph,
+    RandomIt first,
+    RandomIt last,
+    RngT& rng)
+{
+    auto const Length{ static_cast<std::size_t>(std::distance(first, last)) };
+    assert(1 < Length);
+    auto i{ UniformIndex(rng, Length) };
+    auto j{ UniformIndex(rng, Length) };
+    if (i == j)
+        j = (j + 1) % Length;
+    if (j < i)
+        std::swap(i, j);
+
+    auto const Delta{ Opt2Delta(graph, first, last, i, j) };
+    Opt2Reverse(first, i, j);
+    return Delta;
+}
+
+enum class CrossoverOperator
+{
+    Order1, // Keep a segment of A, fill in the rest in the order of B
+    PartiallyMapped, // Keep a segment of A in place, map the clashes of B
+    EdgeRecombination // Build the child from the edges of both parents
+};
+
+// Scratch buffers of the crossover operators, reused between calls so that
+// crossover does not allocate.
+struct CrossoverWorkspace
+{
+    explicit CrossoverWorkspace(std::size_t count = 0);
+
+    // A stamp no city is marked with yet.
+    std::uint32_t NextStamp() noexcept;
+
+    std::size_t count;
+    std::uint32_t stamp;
+    std::unique_ptr<std::uint32_t[]> stamps; // Of each city
+    std::unique_ptr<std::size_t[]> positions; // Of each city
+    std::unique_ptr<std::size_t[]> order; // The cities still to be placed
+    std::unique_ptr<std::size_t[]> edges; // Up to four of each city
+    std::unique_ptr<std::uint8_t[]> degrees; // Edges left of each city
+};
+
+inline CrossoverWorkspace::CrossoverWorkspace(std::size_t count)
+    : count{count}
+    , stamp{}
+    , stamps{std::make_unique<std::uint32_t[]>(count)}
+    , positions{std::make_unique<std::size_t[]>(count)}
+    , order{std::make_unique<std::size_t[]>(count)}
+    , edges{std::make_unique<std::size_t[]>(4 * count)}
+    , degrees{std::make_unique<std::uint8_t[]>(count)}
+{
+}
+
+inline std::uint32_t CrossoverWorkspace::NextStamp() noexcept
+{
+    if (++stamp == 0)
+    {
+        std::fill_n(stamps.get(), count, std::uint32_t{});
+        stamp = 1;
+    }
+    return stamp;
+}
+
+// Copy the length cities of A from offset, wrapping around, to the front of
+// out and follow them with the other cities in the order they appear in B
+// after the segment. O(n).
+template<typename RandomIt, typename OutputIt>
 void Order1Crossover(
     RandomIt firstA,
     RandomIt lastA,
     RandomIt firstB,
     std::size_t offset,
     std::size_t length,
-    RandomIt outIt)
+    OutputIt outIt,
+    CrossoverWorkspace& workspace)
 {
     auto const Count = static_cast<std::size_t>(std::distance(firstA, lastA));
-    auto it = std::rotate_copy(
-        firstA,
-        firstA + offset,
-        lastA,
-        outIt);
-
-    auto i = offset + length;
-    for (; i < Count && it != outIt + Count; ++i)
-        if (std::find(outIt, outIt + length, firstB[i]) == outIt + length)
-            *(it++) = firstB[i];
-
-    i %= Count;
-    for (; i < offset && it != outIt + Count; ++i)
-        if (std::find(outIt, outIt + length, firstB[i]) == outIt + length)
-            *(it++) = firstB[i];
+    assert(offset < Count && length <= Count && Count <= workspace.count);
+    auto const Stamp{ workspace.NextStamp() };
+
+    auto i{ offset };
+    for (std::size_t k{}; k != length; ++k, i = i + 1 == Count ? 0 : i + 1)
+    {
+        workspace.stamps[firstA[i]] = Stamp;
+        *(outIt++) = firstA[i];
+    }
+
+    for (std::size_t k{}; k != Count; ++k, i = i + 1 == Count ? 0 : i + 1)
+        if (workspace.stamps[firstB[i]] != Stamp)
+            *(outIt++) = firstB[i];
+}
+
+// Copy the length cities of A from offset, wrapping around, to the same
+// positions of out. The other positions take the city of B, mapped through
+// the segment while it clashes with a city already copied. O(n).
+template<typename RandomIt, typename OutputIt>
+void PartiallyMappedCrossover(
+    RandomIt firstA,
+    RandomIt lastA,
+    RandomIt firstB,
+    std::size_t offset,
+    std::size_t length,
+    OutputIt outIt,
+    CrossoverWorkspace& workspace)
+{
+    auto const Count = static_cast<std::size_t>(std::distance(firstA, lastA));
+    assert(offset < Count && length <= Count && Count <= workspace.count);
+    auto const Stamp{ workspace.NextStamp() };
+
+    auto const InSegment = [=](std::size_t i)
+    {
+        return (i + Count - offset) % Count < length;
+    };
+
+    for (std::size_t i{}; i != Count; ++i)
+        if (InSegment(i))
+        {
+            workspace.stamps[firstA[i]] = Stamp;
+            workspace.positions[firstA[i]] = i;
+        }
+
+    // Every position of the segment is on at most one chain, so the
+    // mapping is O(n) in total.
+    for (std::size_t i{}; i != Count; ++i)
+    {
+        auto city{ InSegment(i) ? firstA[i] : firstB[i] };
+        if (!InSegment(i))
+            while (workspace.stamps[city] == Stamp)
+                city = firstB[workspace.positions[city]];
+        outIt[i] = city;
+    }
+}
+
+namespace internal
+{
+    inline void RemoveEdge(
+        CrossoverWorkspace& workspace,
+        std::size_t from,
+        std::size_t to) noexcept
+    {
+        auto* const Edges{ workspace.edges.get() + 4 * from };
+        auto& degree{ workspace.degrees[from] };
+        auto const It{ std::find(Edges, Edges + degree, to) };
+        if (It != Edges + degree)
+            *It = Edges[--degree];
+    }
+}
+
+// Build the child from the union of the edges of both parents, starting at
+// the city at offset in A and moving to the neighbour with the fewest edges
+// left. A dead end continues from a city not yet placed. length is not used,
+// it is taken so every operator has the same interface. O(n).
+template<typename RandomIt, typename OutputIt>
+void EdgeRecombinationCrossover(
+    RandomIt firstA,
+    RandomIt lastA,
+    RandomIt firstB,
+    std::size_t offset,
+    std::size_t /* length */,
+    OutputIt outIt,
+    CrossoverWorkspace& workspace)
+{
+    auto const Count = static_cast<std::size_t>(std::distance(firstA, lastA));
+    assert(offset < Count && Count <= workspace.count);
+
+    std::fill_n(workspace.degrees.get(), Count, std::uint8_t{});
+    auto const AddEdges = [&](RandomIt first)
+    {
+        for (std::size_t i{}; i != Count; ++i)
+        {
+            auto const From{ static_cast<std::size_t>(first[i]) };
+            auto const To{ static_cast<std::size_t>(first[i + 1 == Count ? 0 : i + 1]) };
+            auto const Add = [&](std::size_t x, std::size_t y)
+            {
+                auto* const Edges{ workspace.edges.get() + 4 * x };
+                auto& degree{ workspace.degrees[x] };
+                if (x != y && std::find(Edges, Edges + degree, y) == Edges + degree)
+                    Edges[degree++] = y;
+            };
+            Add(From, To);
+            Add(To, From);
+        }
+    };
+    AddEdges(firstA);
+    AddEdges(firstB);
+
+    // The unplaced cities, with the index of each in order
+    std::iota(workspace.order.get(), workspace.order.get() + Count, std::size_t{});
+    std::iota(workspace.positions.get(), workspace.positions.get() + Count, std::size_t{});
+    auto remaining{ Count };
+    auto const Place = [&](std::size_t city)
+    {
+        auto const Last{ workspace.order[--remaining] };
+        workspace.order[workspace.positions[city]] = Last;
+        workspace.positions[Last] = workspace.positions[city];
+
+        auto const* const Edges{ workspace.edges.get() + 4 * city };
+        for (std::size_t k{}; k != workspace.degrees[city]; ++k)
+            internal::RemoveEdge(workspace, Edges[k], city);
+        *(outIt++) = city;
+    };
+
+    std::size_t city{ static_cast<std::size_t>(firstA[offset]) };
+    Place(city);
+    while (remaining != 0)
+    {
+        auto const* const Edges{ workspace.edges.get() + 4 * city };
+        auto const Degree{ workspace.degrees[city] };
+        city = Degree == 0
+            ? workspace.order[remaining - 1]
+            : *std::min_element(
+                Edges,
+                Edges + Degree,
+                [&](auto a, auto b)
+                {
+                    return workspace.degrees[a] < workspace.degrees[b];
+                });
+        Place(city);
+    }
+}
+
+// Apply the crossover operator chosen at run time.
+template<typename RandomIt, typename OutputIt>
+void Recombine(
+    CrossoverOperator crossover,
+    RandomIt firstA,
+    RandomIt lastA,
+    RandomIt firstB,
+    std::size_t offset,
+    std::size_t length,
+    OutputIt outIt,
+    CrossoverWorkspace& workspace)
+{
+    switch (crossover)
+    {
+    case CrossoverOperator::PartiallyMapped:
+        PartiallyMappedCrossover(firstA, lastA, firstB, offset, length, outIt, workspace);
+        break;
+    case CrossoverOperator::EdgeRecombination:
+        EdgeRecombinationCrossover(firstA, lastA, firstB, offset, length, outIt, workspace);
+        break;
+    default:
+        Order1Crossover(firstA, lastA, firstB, offset, length, outIt, workspace);
+        break;
+    }
 }
 
 template<typename RandomIt, typename RngT>
@@ -51,9 +299,7 @@ RandomIt SampleGroup(RandomIt first, RandomIt last, std::size_t k, RngT& rng)
 
     for (auto i = first; i != first + k; ++i)
     {
-        auto c = std::uniform_int_distribution<std::size_t>{
-            0,
-            static_cast<std::size_t>(std::distance(i, last) - 1) }(rng);
+        auto c = UniformIndex(rng, static_cast<std::size_t>(std::distance(i, last)));
         std::swap(*i, i[c]);
     }
 
@@ -72,7 +318,7 @@ ForwardIt Roulette(ForwardIt first, ForwardIt last, RngT& rng, F&& f)
             return acc + f(x);
         });
 
-    auto r = std::uniform_real_distribution<>{0.0, Total}(rng);
+    auto r = Total * UniformUnit(rng);
     for(auto i = first; i != last; ++i)
         if(Total <= (r += f(*i)))
             return i;
@@ -92,10 +338,11 @@ void MoveRandom(
         auto const Length{static_cast<std::size_t>(std::distance(
             firstFrom,
             lastFrom))};
-        auto dis {std::uniform_int_distribution<std::size_t>{0, Length - 1}};
-        auto toMoveIt = firstFrom + dis(rng);
+        auto toMoveIt = firstFrom + UniformIndex(rng, Length);
         std::swap(*firstFrom, *toMoveIt);
-        *firstTo = std::move(*firstFrom);
+        // Swap rather than move, so the replaced values are handed back to
+        // the source range and any storage they own can be reused.
+        std::swap(*firstTo, *firstFrom);
     }
 }
 
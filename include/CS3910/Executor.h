@@ -0,0 +1,373 @@
+#ifndef CS3910__EXECUTOR_H_
+#define CS3910__EXECUTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct ExecutorOptions
+{
+    std::size_t threads; // Including the calling thread, all cores when zero
+    bool pinThreads; // Pin thread i to CPU i while the executor lives, where supported
+
+    // Read CS3910_THREADS and CS3910_PIN_THREADS.
+    static ExecutorOptions FromEnvironment() noexcept;
+};
+
+// A fixed pool of threads that share out parallel loops by work stealing.
+// Every thread has its own deque of tasks: the owner takes from the back and
+// idle threads steal from the front. The thread that starts a loop works on
+// it too, so loops may be nested inside tasks.
+//
+// Loops may be started by tasks or by one thread outside the pool at a time.
+// Loop bodies must not throw.
+class Executor final
+{
+public:
+    explicit Executor(ExecutorOptions const& options = ExecutorOptions{});
+
+    Executor(Executor const&) = delete;
+
+    Executor& operator=(Executor const&) = delete;
+
+    ~Executor();
+
+    // The number of threads running tasks, the calling thread included.
+    std::size_t Concurrency() const noexcept;
+
+    // Call f(i) for every i in [first, last), in chunks of at least grain.
+    template<typename F>
+    void ParallelFor(
+        std::size_t first,
+        std::size_t last,
+        F&& f,
+        std::size_t grain = 1);
+
+    // Combine f(i) for every i in [first, last), starting from identity.
+    // combine must be associative.
+    template<typename T, typename F, typename Combine>
+    T ParallelReduce(
+        std::size_t first,
+        std::size_t last,
+        T identity,
+        F&& f,
+        Combine&& combine,
+        std::size_t grain = 1);
+private:
+    struct Job
+    {
+        void (*run)(void* body, std::size_t first, std::size_t last);
+        void* body;
+        std::atomic<std::size_t> pending;
+    };
+
+    struct Task
+    {
+        Job* job;
+        std::size_t first;
+        std::size_t last;
+    };
+
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // Fixed before the workers start, they read it without a lock
+    std::size_t threads_;
+
+    // One queue per worker and a last one for the outside caller
+    std::unique_ptr<Queue[]> queues_;
+
+    std::vector<std::thread> workers_;
+
+    std::atomic<std::size_t> queued_;
+
+    std::mutex sleep_;
+
+    std::condition_variable wake_;
+
+    bool stop_;
+
+#if defined(__linux__)
+    // The thread that made the executor and its affinity before pinning,
+    // given back by the destructor
+    pthread_t caller_;
+
+    cpu_set_t callerCpus_;
+
+    bool pinnedCaller_;
+#endif
+
+    template<typename Body>
+    static void Invoke(void* body, std::size_t first, std::size_t last);
+
+    void Run(Job& job, std::size_t first, std::size_t last, std::size_t grain);
+
+    std::size_t Self() const noexcept;
+
+    bool TryRunOne(std::size_t self);
+
+    void Work(std::size_t self);
+
+    static void Pin(std::size_t cpu) noexcept;
+
+    static thread_local Executor const* current_;
+
+    static thread_local std::size_t currentIndex_;
+};
+
+inline thread_local Executor const* Executor::current_{};
+
+inline thread_local std::size_t Executor::currentIndex_{};
+
+inline ExecutorOptions ExecutorOptions::FromEnvironment() noexcept
+{
+    ExecutorOptions options{};
+    if (auto const Threads{ std::getenv("CS3910_THREADS") })
+        options.threads = std::strtoull(Threads, nullptr, 10);
+    if (auto const Pin{ std::getenv("CS3910_PIN_THREADS") })
+        options.pinThreads = std::strcmp(Pin, "0") != 0;
+    return options;
+}
+
+inline Executor::Executor(ExecutorOptions const& options)
+    : threads_{options.threads != 0
+        ? options.threads
+        : std::max<std::size_t>(1, std::thread::hardware_concurrency())}
+    , queues_{std::make_unique<Queue[]>(threads_)}
+    , workers_{}
+    , queued_{0}
+    , sleep_{}
+    , wake_{}
+    , stop_{false}
+#if defined(__linux__)
+    , caller_{pthread_self()}
+    , callerCpus_{}
+    , pinnedCaller_{false}
+#endif
+{
+    if (options.pinThreads)
+    {
+#if defined(__linux__)
+        pinnedCaller_ = pthread_getaffinity_np(
+            caller_,
+            sizeof(callerCpus_),
+            &callerCpus_) == 0;
+#endif
+        Pin(0);
+    }
+    workers_.reserve(threads_ - 1);
+    for (std::size_t i{}; i + 1 < threads_; ++i)
+        workers_.emplace_back([=]()
+        {
+            if (options.pinThreads)
+                Pin(i + 1);
+            Work(i);
+        });
+}
+
+inline Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> lock{ sleep_ };
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+
+#if defined(__linux__)
+    if (pinnedCaller_)
+        pthread_setaffinity_np(caller_, sizeof(callerCpus_), &callerCpus_);
+#endif
+}
+
+inline std::size_t Executor::Concurrency() const noexcept
+{
+    return threads_;
+}
+
+template<typename F>
+void Executor::ParallelFor(
+    std::size_t first,
+    std::size_t last,
+    F&& f,
+    std::size_t grain)
+{
+    auto body = [&f](std::size_t from, std::size_t to)
+    {
+        for (; from != to; ++from)
+            f(from);
+    };
+    Job job{&Invoke<decltype(body)>, &body, {}};
+    Run(job, first, last, grain);
+}
+
+template<typename T, typename F, typename Combine>
+T Executor::ParallelReduce(
+    std::size_t first,
+    std::size_t last,
+    T identity,
+    F&& f,
+    Combine&& combine,
+    std::size_t grain)
+{
+    if (last <= first)
+        return identity;
+
+    // Reduce a few chunks per thread and then the chunks in order
+    auto const Count{ last - first };
+    grain = std::max<std::size_t>(grain, 1);
+    auto const Chunks{ std::min((Count + grain - 1) / grain, 4 * Concurrency()) };
+    auto const Size{ (Count + Chunks - 1) / Chunks };
+    std::vector<T> partial(Chunks, identity);
+    ParallelFor(0, Chunks, [&](std::size_t chunk)
+    {
+        auto const From{ first + chunk * Size };
+        auto const To{ std::min(last, From + Size) };
+        auto value{ identity };
+        for (auto i{ From }; i < To; ++i)
+            value = combine(std::move(value), f(i));
+        partial[chunk] = std::move(value);
+    });
+    return std::accumulate(partial.begin(), partial.end(), identity, combine);
+}
+
+template<typename Body>
+void Executor::Invoke(void* body, std::size_t first, std::size_t last)
+{
+    (*static_cast<Body*>(body))(first, last);
+}
+
+inline void Executor::Run(
+    Job& job,
+    std::size_t first,
+    std::size_t last,
+    std::size_t grain)
+{
+    if (last <= first)
+        return;
+
+    auto const Count{ last - first };
+    grain = std::max<std::size_t>(grain, 1);
+    if (Count <= grain || threads_ == 1)
+    {
+        job.run(job.body, first, last);
+        return;
+    }
+
+    // A few chunks per thread leave room to balance uneven work, and
+    // consecutive chunks go to each queue to keep the threads apart.
+    auto const Chunks{ std::min((Count + grain - 1) / grain, 4 * Concurrency()) };
+    auto const Size{ (Count + Chunks - 1) / Chunks };
+    auto const Used{ (Count + Size - 1) / Size };
+    job.pending.store(Used, std::memory_order_relaxed);
+
+    auto const PerQueue{ (Used + Concurrency() - 1) / Concurrency() };
+    auto const Self{ this->Self() };
+    queued_.fetch_add(Used, std::memory_order_release);
+    for (std::size_t chunk{}; chunk < Used; ++chunk)
+    {
+        auto& queue{ queues_[(Self + chunk / PerQueue) % Concurrency()] };
+        auto const From{ first + chunk * Size };
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+        queue.tasks.push_back(Task{&job, From, std::min(last, From + Size)});
+    }
+    {
+        std::lock_guard<std::mutex> lock{ sleep_ };
+    }
+    wake_.notify_all();
+
+    // Help with any work, not only this job, until every chunk is done
+    while (job.pending.load(std::memory_order_acquire) != 0)
+        if (!TryRunOne(Self))
+            std::this_thread::yield();
+}
+
+inline std::size_t Executor::Self() const noexcept
+{
+    return current_ == this ? currentIndex_ : threads_ - 1;
+}
+
+inline bool Executor::TryRunOne(std::size_t self)
+{
+    Task task{};
+    bool found{ false };
+    for (std::size_t i{}; i < Concurrency() && !found; ++i)
+    {
+        auto const Victim{ (self + i) % Concurrency() };
+        auto& queue{ queues_[Victim] };
+        std::lock_guard<std::mutex> lock{ queue.mutex };
+        if (queue.tasks.empty())
+            continue;
+        if (Victim == self)
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        found = true;
+    }
+    if (!found)
+        return false;
+
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    task.job->run(task.job->body, task.first, task.last);
+    task.job->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+inline void Executor::Work(std::size_t self)
+{
+    current_ = this;
+    currentIndex_ = self;
+    for (;;)
+    {
+        if (TryRunOne(self))
+            continue;
+
+        std::unique_lock<std::mutex> lock{ sleep_ };
+        wake_.wait(lock, [this]()
+        {
+            return stop_ || queued_.load(std::memory_order_acquire) != 0;
+        });
+        if (stop_)
+            return;
+    }
+}
+
+inline void Executor::Pin(std::size_t cpu) noexcept
+{
+#if defined(__linux__)
+    auto const Cpus{ std::max<std::size_t>(1, std::thread::hardware_concurrency()) };
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % Cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+#endif // !CS3910__EXECUTOR_H_
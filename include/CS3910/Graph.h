@@ -4,7 +4,9 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <type_traits>
 
 template<typename T>
 class AdjacencyMatrix final
@@ -78,17 +80,336 @@ T Weight(AdjacencyMatrix<T> const& graph, std::size_t x, std::size_t y)
     return graph(x, y);
 }
 
-template<typename T, typename RandomIt>
-T CostOf(AdjacencyMatrix<T> const& m, RandomIt first, RandomIt last)
+// A symmetric matrix storing only the lower triangle and the diagonal, packed
+// row after row, so (x, y) and (y, x) are the same value.
+template<typename T>
+class SymmetricMatrix final
+{
+public:
+    using value_type = T;
+
+    explicit SymmetricMatrix(std::size_t count);
+
+    constexpr value_type& operator()(std::size_t x, std::size_t y) noexcept;
+
+    constexpr value_type operator()(std::size_t x, std::size_t y) const noexcept;
+
+    constexpr std::size_t Count() const noexcept;
+
+    // The number of values stored.
+    constexpr std::size_t Size() const noexcept;
+
+    constexpr value_type* Data() noexcept;
+
+    constexpr value_type const* Data() const noexcept;
+private:
+    std::unique_ptr<value_type[]> data_;
+
+    std::size_t count_;
+
+    static constexpr std::size_t Index(std::size_t x, std::size_t y) noexcept;
+};
+
+template<typename T>
+SymmetricMatrix<T>::SymmetricMatrix(std::size_t count)
+ : data_{std::make_unique<value_type[]>(count * (count + 1) / 2)}
+ , count_{count}
+{
+}
+
+template<typename T>
+constexpr typename SymmetricMatrix<T>::value_type&
+SymmetricMatrix<T>::operator()(
+    std::size_t x,
+    std::size_t y)
+    noexcept
+{
+    assert(x < count_ && "The x position must be less than the vertex count.");
+    assert(y < count_ && "The y position must be less than the vertex count.");
+    return data_.get()[Index(x, y)];
+}
+
+template<typename T>
+constexpr typename SymmetricMatrix<T>::value_type
+SymmetricMatrix<T>::operator()(
+    std::size_t x,
+    std::size_t y)
+    const noexcept
+{
+    assert(x < count_ && "The x position must be less than the vertex count.");
+    assert(y < count_ && "The y position must be less than the vertex count.");
+    return data_.get()[Index(x, y)];
+}
+
+template<typename T>
+constexpr std::size_t SymmetricMatrix<T>::Count() const noexcept
+{
+    return count_;
+}
+
+template<typename T>
+constexpr std::size_t SymmetricMatrix<T>::Size() const noexcept
+{
+    return count_ * (count_ + 1) / 2;
+}
+
+template<typename T>
+constexpr typename SymmetricMatrix<T>::value_type*
+SymmetricMatrix<T>::Data() noexcept
+{
+    return data_.get();
+}
+
+template<typename T>
+constexpr typename SymmetricMatrix<T>::value_type const*
+SymmetricMatrix<T>::Data() const noexcept
+{
+    return data_.get();
+}
+
+template<typename T>
+constexpr std::size_t SymmetricMatrix<T>::Index(
+    std::size_t x,
+    std::size_t y)
+    noexcept
+{
+    if (x < y)
+        std::swap(x, y);
+    return x * (x + 1) / 2 + y;
+}
+
+template<typename T>
+T& Weight(SymmetricMatrix<T>& graph, std::size_t x, std::size_t y)
+{
+    return graph(x, y);
+}
+
+template<typename T>
+T Weight(SymmetricMatrix<T> const& graph, std::size_t x, std::size_t y)
+{
+    return graph(x, y);
+}
+
+// A read only matrix in the layout of SymmetricMatrix over values it does not
+// own, such as the matrix of a packed problem file that many processes map.
+// owner keeps the values alive.
+template<typename T>
+class MappedMatrix final
+{
+public:
+    using value_type = T;
+
+    MappedMatrix(
+        std::shared_ptr<void const> owner,
+        value_type const* data,
+        std::size_t count) noexcept;
+
+    // Take over the values of a matrix computed in memory.
+    explicit MappedMatrix(SymmetricMatrix<T>&& matrix);
+
+    constexpr value_type operator()(std::size_t x, std::size_t y) const noexcept;
+
+    constexpr std::size_t Count() const noexcept;
+
+    // The number of values stored.
+    constexpr std::size_t Size() const noexcept;
+
+    constexpr value_type const* Data() const noexcept;
+private:
+    std::shared_ptr<void const> owner_;
+
+    value_type const* data_;
+
+    std::size_t count_;
+};
+
+template<typename T>
+MappedMatrix<T>::MappedMatrix(
+    std::shared_ptr<void const> owner,
+    value_type const* data,
+    std::size_t count)
+    noexcept
+    : owner_{std::move(owner)}
+    , data_{data}
+    , count_{count}
+{
+}
+
+template<typename T>
+MappedMatrix<T>::MappedMatrix(SymmetricMatrix<T>&& matrix)
+    : owner_{}
+    , data_{}
+    , count_{matrix.Count()}
+{
+    auto owner{ std::make_shared<SymmetricMatrix<T>>(std::move(matrix)) };
+    data_ = owner->Data();
+    owner_ = std::move(owner);
+}
+
+template<typename T>
+constexpr typename MappedMatrix<T>::value_type
+MappedMatrix<T>::operator()(
+    std::size_t x,
+    std::size_t y)
+    const noexcept
+{
+    assert(x < count_ && "The x position must be less than the vertex count.");
+    assert(y < count_ && "The y position must be less than the vertex count.");
+    if (x < y)
+        std::swap(x, y);
+    return data_[x * (x + 1) / 2 + y];
+}
+
+template<typename T>
+constexpr std::size_t MappedMatrix<T>::Count() const noexcept
+{
+    return count_;
+}
+
+template<typename T>
+constexpr std::size_t MappedMatrix<T>::Size() const noexcept
+{
+    return count_ * (count_ + 1) / 2;
+}
+
+template<typename T>
+constexpr typename MappedMatrix<T>::value_type const*
+MappedMatrix<T>::Data() const noexcept
+{
+    return data_;
+}
+
+template<typename T>
+T Weight(MappedMatrix<T> const& graph, std::size_t x, std::size_t y)
+{
+    return graph(x, y);
+}
+
+// The type route costs of a graph are summed in. Weights may be stored as
+// float or std::int32_t, but a sum of millions of them needs double or
+// std::int64_t.
+template<typename Graph>
+using CostType = std::conditional_t<
+    std::is_integral_v<typename Graph::value_type>,
+    std::int64_t,
+    double>;
+
+// The cost of the closed route [first, last) for any graph or distance
+// provider with a Weight overload.
+template<typename Graph, typename RandomIt>
+CostType<Graph> CostOf(Graph const& m, RandomIt first, RandomIt last)
 {
     assert(first != last && "No empty ranges allowed");
     assert(std::distance(first, last) == m.Count() && "Not all nodes visited");
     assert(std::unique(first, last) == last && "Visiting duplicate nodes");
 
-    T totalCost{Weight(m, *first, last[-1])};
+    CostType<Graph> totalCost{Weight(m, *first, last[-1])};
     for (; first + 1 != last; ++first)
         totalCost += Weight(m, first[0], first[1]);
     return totalCost;
 }
 
+// Order the nodes of [first, last) by always visiting the nearest unvisited
+// node next, starting from the first. O(n^2) lookups.
+template<typename Graph, typename RandomIt>
+void NearestNeighbourRoute(Graph const& m, RandomIt first, RandomIt last)
+{
+    for (; first != last && first + 1 != last; ++first)
+    {
+        auto nearest{ first + 1 };
+        auto weight{ Weight(m, *first, *nearest) };
+        for (auto it{ nearest + 1 }; it != last; ++it)
+            if (auto const W{ Weight(m, *first, *it) }; W < weight)
+            {
+                nearest = it;
+                weight = W;
+            }
+        std::iter_swap(first + 1, nearest);
+    }
+}
+
+namespace internal
+{
+    // Walk four routes in step, so the weight lookups of different routes
+    // are independent and their cache misses overlap. route(r) gives the
+    // first node of route r. The sums are made in the same order as CostOf.
+    template<typename Graph, typename RouteAt>
+    void CostOfInterleaved(
+        Graph const& m,
+        RouteAt route,
+        std::size_t count,
+        CostType<Graph>* out)
+    {
+        auto const Nodes{ m.Count() };
+        assert(Nodes != 0);
+
+        std::size_t r{};
+        for (; r + 4 <= count; r += 4)
+        {
+            auto const A{ route(r) };
+            auto const B{ route(r + 1) };
+            auto const C{ route(r + 2) };
+            auto const D{ route(r + 3) };
+            CostType<Graph> a{Weight(m, A[0], A[Nodes - 1])};
+            CostType<Graph> b{Weight(m, B[0], B[Nodes - 1])};
+            CostType<Graph> c{Weight(m, C[0], C[Nodes - 1])};
+            CostType<Graph> d{Weight(m, D[0], D[Nodes - 1])};
+            for (std::size_t i{ 1 }; i < Nodes; ++i)
+            {
+                a += Weight(m, A[i - 1], A[i]);
+                b += Weight(m, B[i - 1], B[i]);
+                c += Weight(m, C[i - 1], C[i]);
+                d += Weight(m, D[i - 1], D[i]);
+            }
+            out[r] = a;
+            out[r + 1] = b;
+            out[r + 2] = c;
+            out[r + 3] = d;
+        }
+
+        for (; r < count; ++r)
+        {
+            auto const A{ route(r) };
+            CostType<Graph> a{Weight(m, A[0], A[Nodes - 1])};
+            for (std::size_t i{ 1 }; i < Nodes; ++i)
+                a += Weight(m, A[i - 1], A[i]);
+            out[r] = a;
+        }
+    }
+}
+
+// The costs of count closed routes of m.Count() nodes each, where routes[r]
+// is the first node of route r.
+template<typename Graph, typename RouteIt>
+void CostOfEach(
+    Graph const& m,
+    RouteIt routes,
+    std::size_t count,
+    CostType<Graph>* out)
+{
+    internal::CostOfInterleaved(
+        m,
+        [=](std::size_t r){ return routes[r]; },
+        count,
+        out);
+}
+
+// The costs of count closed routes stored one after another, the first
+// node of route r being first[r * stride].
+template<typename Graph, typename RandomIt>
+void CostOfBlock(
+    Graph const& m,
+    RandomIt first,
+    std::size_t stride,
+    std::size_t count,
+    CostType<Graph>* out)
+{
+    assert(m.Count() <= stride);
+    internal::CostOfInterleaved(
+        m,
+        [=](std::size_t r){ return first + r * stride; },
+        count,
+        out);
+}
+
 #endif // !CS3910__GRAPH_H_
\ No newline at end of file
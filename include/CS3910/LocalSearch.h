@@ -0,0 +1,542 @@
+#ifndef CS3910__LOCALSEARCH_H_
+#define CS3910__LOCALSEARCH_H_
+
+#include "Candidates.h"
+#include "Graph.h"
+#include "Neighbourhood.h"
+#include "Random.h"
+#include "Tour.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The moves tried by LocalSearch, each level adding to those before it.
+enum class LocalSearchMove
+{
+    Opt2, // Replace two edges
+    OrOpt, // Move a segment of up to three cities elsewhere, maybe reversed
+    LinKernighan // Chains of 2-opt moves, kept up to their best closing
+};
+
+// Improves a tour with moves that bring a city next to one of its
+// candidates. Cities whose moves may have changed are queued, the rest keep
+// their don't look bit, so after the first pass only the cities around
+// applied moves are tried again. Every reversal is journaled, so all moves
+// since the last Commit can be rolled back.
+template<typename Graph, typename Tour>
+class LocalSearch final
+{
+public:
+    using value_type = typename Tour::value_type;
+
+    using cost_type = CostType<Graph>;
+
+    // The longest chain of a LinKernighan move
+    static constexpr std::size_t DEFAULT_DEPTH{ 10 };
+
+    // The cities of a segment an OrOpt move may move
+    static constexpr std::size_t OR_LENGTH{ 3 };
+
+    // The longest segments a Kick exchanges
+    static constexpr std::size_t KICK_LENGTH{ 50 };
+
+    LocalSearch(
+        Graph const& graph,
+        CandidateList const& candidates,
+        LocalSearchMove move,
+        std::size_t depth = DEFAULT_DEPTH);
+
+    // Queue city to have its moves tried, unless it already is.
+    void Mark(value_type city);
+
+    // Queue every city in the order of tour.
+    void MarkAll(Tour const& tour);
+
+    // Apply improving moves around the queued cities until the queue is
+    // empty. Returns the change in cost.
+    cost_type Run(Tour& tour);
+
+    // Exchange two adjacent segments of up to KICK_LENGTH cities at a random
+    // place, a double bridge that no sequence of the moves above undoes
+    // cheaply, and queue the cities at its ends. Returns the change in cost.
+    template<typename RngT>
+    cost_type Kick(Tour& tour, RngT& rng);
+
+    // Keep the moves applied so far.
+    void Commit() noexcept;
+
+    // Undo every move since the last Commit.
+    void Rollback(Tour& tour);
+
+    // The least gain that counts as an improvement, see ImprovementThreshold.
+    cost_type Epsilon() const noexcept;
+private:
+    struct Reversal
+    {
+        value_type from;
+        value_type to;
+        value_type outside; // A city that is not in the segment
+    };
+
+    Graph const& graph_;
+
+    CandidateList const& candidates_;
+
+    LocalSearchMove move_;
+
+    std::size_t depth_;
+
+    cost_type epsilon_;
+
+    // A ring of the queued cities, each at most once
+    std::unique_ptr<value_type[]> queue_;
+
+    std::size_t head_;
+
+    std::size_t queued_;
+
+    std::unique_ptr<bool[]> isQueued_;
+
+    std::vector<Reversal> journal_;
+
+    // The ends of the edges changed by the move being tried
+    std::vector<value_type> touched_;
+
+    std::vector<std::pair<value_type, value_type>> added_;
+
+    cost_type Distance(value_type x, value_type y) const;
+
+    // Reverse the segment with ends from and to that does not hold outside.
+    void ReverseSegment(Tour& tour, value_type from, value_type to, value_type outside);
+
+    void Undo(Tour& tour, std::size_t size);
+
+    bool Added(value_type x, value_type y) const noexcept;
+
+    // Chains of 2-opt moves removing the edge (t1, t2) first. Returns the
+    // gain, the chain is undone when there is none.
+    cost_type ImproveChain(Tour& tour, value_type t1, value_type t2);
+
+    // Move a segment of up to OR_LENGTH cities ending at t1 next to one of
+    // the candidates of its ends. Returns the gain of the first improving
+    // move, which is applied.
+    cost_type ImproveSegment(Tour& tour, value_type t1);
+};
+
+// Improve the closed route [first, last) with LocalSearch until no move is
+// left, starting from every city, on the tour WithTour picks for its size.
+// Returns the change in cost.
+template<typename Graph, typename RandomIt>
+auto ImproveRoute(
+    Graph const& graph,
+    CandidateList const& candidates,
+    RandomIt first,
+    RandomIt last,
+    LocalSearchMove move);
+
+// As NearestNeighbourRoute, but looking for the nearest unvisited city among
+// the candidates first, so only the cities whose candidates are all visited
+// cost a scan of the rest.
+template<typename Graph, typename RandomIt>
+void NearestNeighbourRoute(
+    Graph const& m,
+    CandidateList const& candidates,
+    RandomIt first,
+    RandomIt last);
+
+template<typename Graph, typename Tour>
+LocalSearch<Graph, Tour>::LocalSearch(
+    Graph const& graph,
+    CandidateList const& candidates,
+    LocalSearchMove move,
+    std::size_t depth)
+    : graph_{graph}
+    , candidates_{candidates}
+    , move_{move}
+    , depth_{move == LocalSearchMove::LinKernighan ? std::max<std::size_t>(depth, 1) : 1}
+    , epsilon_{-internal::ImprovementThreshold<Graph>(internal::EdgeScale(graph, candidates))}
+    , queue_{std::make_unique<value_type[]>(graph.Count())}
+    , head_{}
+    , queued_{}
+    , isQueued_{std::make_unique<bool[]>(graph.Count())}
+    , journal_{}
+    , touched_{}
+    , added_{}
+{
+    assert(candidates.Count() == graph.Count());
+}
+
+template<typename Graph, typename Tour>
+void LocalSearch<Graph, Tour>::Mark(value_type city)
+{
+    if (isQueued_[city])
+        return;
+    isQueued_[city] = true;
+    queue_[(head_ + queued_++) % graph_.Count()] = city;
+}
+
+template<typename Graph, typename Tour>
+void LocalSearch<Graph, Tour>::MarkAll(Tour const& tour)
+{
+    if (tour.Count() == 0)
+        return;
+    auto city{ value_type{} };
+    for (std::size_t i{}; i < tour.Count(); ++i, city = tour.Next(city))
+        Mark(city);
+}
+
+template<typename Graph, typename Tour>
+typename LocalSearch<Graph, Tour>::cost_type
+LocalSearch<Graph, Tour>::Run(Tour& tour)
+{
+    cost_type total{};
+    while (queued_ != 0)
+    {
+        auto const T1{ queue_[head_] };
+        head_ = (head_ + 1) % graph_.Count();
+        --queued_;
+        isQueued_[T1] = false;
+        if (tour.Count() < 8)
+            continue;
+
+        // Either neighbour may be the first city of a chain
+        touched_.clear();
+        auto gain{ ImproveChain(tour, T1, tour.Next(T1)) };
+        if (!(epsilon_ < gain))
+            gain = ImproveChain(tour, T1, tour.Prev(T1));
+        if (!(epsilon_ < gain) && move_ != LocalSearchMove::Opt2)
+            gain = ImproveSegment(tour, T1);
+        if (!(epsilon_ < gain))
+            continue;
+
+        total -= gain;
+        Mark(T1);
+        for (auto const City : touched_)
+            Mark(City);
+    }
+    return total;
+}
+
+template<typename Graph, typename Tour>
+template<typename RngT>
+typename LocalSearch<Graph, Tour>::cost_type
+LocalSearch<Graph, Tour>::Kick(Tour& tour, RngT& rng)
+{
+    auto const Count{ tour.Count() };
+    if (Count < 8)
+        return cost_type{};
+
+    // a2 [b1 .. b2] [c1 .. c2] d1 becomes a2 [c1 .. c2] [b1 .. b2] d1
+    auto const Longest{ std::min(KICK_LENGTH, (Count - 2) / 2) };
+    auto const A2{ static_cast<value_type>(UniformIndex(rng, Count)) };
+    auto const B1{ tour.Next(A2) };
+    auto b2{ B1 };
+    for (auto i{ UniformIndex(rng, Longest) }; i != 0; --i)
+        b2 = tour.Next(b2);
+    auto const C1{ tour.Next(b2) };
+    auto c2{ C1 };
+    for (auto i{ UniformIndex(rng, Longest) }; i != 0; --i)
+        c2 = tour.Next(c2);
+    auto const D1{ tour.Next(c2) };
+
+    auto const Delta{ Distance(A2, C1) + Distance(c2, B1) + Distance(b2, D1)
+        - Distance(A2, B1) - Distance(b2, C1) - Distance(c2, D1) };
+    ReverseSegment(tour, B1, c2, A2);
+    ReverseSegment(tour, c2, C1, A2);
+    ReverseSegment(tour, b2, B1, A2);
+    for (auto const City : { A2, B1, b2, C1, c2, D1 })
+        Mark(City);
+    return Delta;
+}
+
+template<typename Graph, typename Tour>
+void LocalSearch<Graph, Tour>::Commit() noexcept
+{
+    journal_.clear();
+}
+
+template<typename Graph, typename Tour>
+void LocalSearch<Graph, Tour>::Rollback(Tour& tour)
+{
+    Undo(tour, 0);
+    while (queued_ != 0)
+    {
+        isQueued_[queue_[head_]] = false;
+        head_ = (head_ + 1) % graph_.Count();
+        --queued_;
+    }
+}
+
+template<typename Graph, typename Tour>
+typename LocalSearch<Graph, Tour>::cost_type
+LocalSearch<Graph, Tour>::Epsilon() const noexcept
+{
+    return epsilon_;
+}
+
+template<typename Graph, typename Tour>
+typename LocalSearch<Graph, Tour>::cost_type
+LocalSearch<Graph, Tour>::Distance(value_type x, value_type y) const
+{
+    return Weight(graph_, x, y);
+}
+
+template<typename Graph, typename Tour>
+void LocalSearch<Graph, Tour>::ReverseSegment(
+    Tour& tour,
+    value_type from,
+    value_type to,
+    value_type outside)
+{
+    if (tour.Between(from, outside, to))
+        std::swap(from, to);
+    touched_.push_back(tour.Prev(from));
+    touched_.push_back(from);
+    touched_.push_back(to);
+    touched_.push_back(tour.Next(to));
+    tour.Reverse(from, to);
+    journal_.push_back({from, to, outside});
+}
+
+template<typename Graph, typename Tour>
+void LocalSearch<Graph, Tour>::Undo(Tour& tour, std::size_t size)
+{
+    while (size < journal_.size())
+    {
+        auto const Last{ journal_.back() };
+        journal_.pop_back();
+        auto from{ Last.from };
+        auto to{ Last.to };
+        if (tour.Between(from, Last.outside, to))
+            std::swap(from, to);
+        tour.Reverse(from, to);
+    }
+}
+
+template<typename Graph, typename Tour>
+bool LocalSearch<Graph, Tour>::Added(value_type x, value_type y) const noexcept
+{
+    return std::find_if(
+        added_.begin(),
+        added_.end(),
+        [=](auto const& edge)
+        {
+            return (edge.first == x && edge.second == y)
+                || (edge.first == y && edge.second == x);
+        }) != added_.end();
+}
+
+template<typename Graph, typename Tour>
+typename LocalSearch<Graph, Tour>::cost_type
+LocalSearch<Graph, Tour>::ImproveChain(Tour& tour, value_type t1, value_type t2)
+{
+    // Each step removes (t1, t2) and (t3, t4) and adds (t2, t3) and the
+    // closing edge (t4, t1), whose removal starts the next step. gain is
+    // what the chain has saved before closing.
+    auto const Start{ journal_.size() };
+    auto const T2{ t2 };
+    added_.clear();
+    auto gain{ Distance(t1, t2) };
+    cost_type bestGain{};
+    std::size_t bestSteps{};
+
+    // The best plain 2-opt move, in case a longer chain does worse
+    value_type opt2T4{};
+    cost_type opt2Gain{};
+    for (std::size_t step{}; step < depth_; ++step)
+    {
+        auto const Forward{ tour.Next(t1) == t2 };
+        auto const After{ Forward ? tour.Next(t2) : tour.Prev(t2) };
+        auto const Last{ step + 1 == depth_ };
+
+        // The last step picks the best closing move, the others the best
+        // gain before closing
+        value_type t3{};
+        value_type t4{};
+        cost_type bestScore{};
+        auto found{ false };
+        auto const Candidates{ candidates_(t2) };
+        for (auto k{ Candidates }; k != Candidates + candidates_.Size(); ++k)
+        {
+            auto const T3{ static_cast<value_type>(*k) };
+            auto const Open{ gain - Distance(t2, T3) };
+            if (!(epsilon_ < Open))
+                break;
+            if (T3 == t1 || T3 == After || Added(t2, T3))
+                continue;
+            auto const T4{ Forward ? tour.Prev(T3) : tour.Next(T3) };
+            if (Added(T3, T4))
+                continue;
+            auto const Closed{ Open + Distance(T3, T4) - Distance(T4, t1) };
+            if (step == 0 && opt2Gain < Closed)
+            {
+                opt2T4 = T4;
+                opt2Gain = Closed;
+            }
+            auto const Score{ Last ? Closed : Open + Distance(T3, T4) };
+            if (!found || bestScore < Score)
+            {
+                t3 = T3;
+                t4 = T4;
+                bestScore = Score;
+                found = true;
+            }
+        }
+        if (!found)
+            break;
+
+        ReverseSegment(tour, t2, t4, t1);
+        added_.emplace_back(t2, t3);
+        gain = gain - Distance(t2, t3) + Distance(t3, t4);
+        if (auto const Closed{ gain - Distance(t4, t1) }; bestGain < Closed)
+        {
+            bestGain = Closed;
+            bestSteps = step + 1;
+        }
+        t2 = t4;
+    }
+
+    Undo(tour, Start + bestSteps);
+    if (!(bestGain < opt2Gain))
+        return bestGain;
+    if (bestSteps != 0)
+        Undo(tour, Start);
+    ReverseSegment(tour, T2, opt2T4, t1);
+    return opt2Gain;
+}
+
+template<typename Graph, typename Tour>
+typename LocalSearch<Graph, Tour>::cost_type
+LocalSearch<Graph, Tour>::ImproveSegment(Tour& tour, value_type t1)
+{
+    for (std::size_t length{ 1 }; length <= OR_LENGTH; ++length)
+        for (auto const AtStart : { true, false })
+        {
+            // The segment runs forward from s1 to s2 and sits between p and n
+            auto s1{ t1 };
+            auto s2{ t1 };
+            for (std::size_t i{ 1 }; i < length; ++i)
+                if (AtStart)
+                    s2 = tour.Next(s2);
+                else
+                    s1 = tour.Prev(s1);
+            auto const P{ tour.Prev(s1) };
+            auto const N{ tour.Next(s2) };
+            if (tour.Between(s1, P, s2) || tour.Between(s1, N, s2) || P == N)
+                continue;
+
+            auto const Removed{ Distance(P, s1) + Distance(s2, N) - Distance(P, N) };
+            if (!(epsilon_ < Removed))
+                continue;
+
+            for (auto const End : { s1, s2 })
+            {
+                auto const Candidates{ candidates_(End) };
+                for (auto k{ Candidates }; k != Candidates + candidates_.Size(); ++k)
+                {
+                    auto const C{ static_cast<value_type>(*k) };
+                    if (!(Distance(End, C) < Removed))
+                        break;
+                    if (tour.Between(s1, C, s2))
+                        continue;
+
+                    // Insert between u and the city v after it
+                    for (auto const Before : { true, false })
+                    {
+                        auto const U{ Before ? C : tour.Prev(C) };
+                        auto const V{ Before ? tour.Next(C) : C };
+                        if (tour.Between(s1, U, s2) || tour.Between(s1, V, s2))
+                            continue;
+                        auto const Straight{ Distance(U, s1) + Distance(s2, V) - Distance(U, V) };
+                        auto const Reversed{ Distance(U, s2) + Distance(s1, V) - Distance(U, V) };
+                        auto const Gain{ Removed - std::min(Straight, Reversed) };
+                        if (!(epsilon_ < Gain))
+                            continue;
+
+                        // p [s1 .. s2] n .. u v becomes p n .. u [s2 .. s1] v
+                        ReverseSegment(tour, s1, U, P);
+                        ReverseSegment(tour, U, N, P);
+                        if (Straight < Reversed)
+                            ReverseSegment(tour, s1, s2, P);
+                        return Gain;
+                    }
+                }
+            }
+        }
+    return cost_type{};
+}
+
+template<typename Graph, typename RandomIt>
+auto ImproveRoute(
+    Graph const& graph,
+    CandidateList const& candidates,
+    RandomIt first,
+    RandomIt last,
+    LocalSearchMove move)
+{
+    using I = typename std::iterator_traits<RandomIt>::value_type;
+    auto const Count{ static_cast<std::size_t>(std::distance(first, last)) };
+    typename LocalSearch<Graph, ArrayTour<I>>::cost_type delta{};
+    WithTour<I>(Count, [&](auto tag)
+    {
+        using Tour = typename decltype(tag)::type;
+        Tour tour{ Count };
+        tour.Assign(first);
+        LocalSearch<Graph, Tour> search{ graph, candidates, move };
+        search.MarkAll(tour);
+        delta = search.Run(tour);
+        tour.Copy(first, *first);
+    });
+    return delta;
+}
+
+template<typename Graph, typename RandomIt>
+void NearestNeighbourRoute(
+    Graph const& m,
+    CandidateList const& candidates,
+    RandomIt first,
+    RandomIt last)
+{
+    auto const Count{ static_cast<std::size_t>(std::distance(first, last)) };
+    assert(candidates.Empty() || candidates.Count() == Count);
+    std::vector<std::size_t> positions(Count);
+    for (std::size_t i{}; i < Count; ++i)
+        positions[first[i]] = i;
+
+    for (std::size_t i{}; i + 1 < Count; ++i)
+    {
+        auto const City{ first[i] };
+        auto next{ Count };
+        auto const Candidates{ candidates(City) };
+        for (auto k{ Candidates }; k != Candidates + candidates.Size(); ++k)
+            if (i < positions[*k])
+            {
+                next = positions[*k];
+                break;
+            }
+
+        if (next == Count)
+        {
+            next = i + 1;
+            auto weight{ Weight(m, City, first[next]) };
+            for (auto j{ next + 1 }; j < Count; ++j)
+                if (auto const W{ Weight(m, City, first[j]) }; W < weight)
+                {
+                    next = j;
+                    weight = W;
+                }
+        }
+
+        using std::swap;
+        swap(first[i + 1], first[next]);
+        positions[first[i + 1]] = i + 1;
+        positions[first[next]] = next;
+    }
+}
+
+#endif // !CS3910__LOCALSEARCH_H_
@@ -0,0 +1,124 @@
+#ifndef CS3910__MAPPEDFILE_H_
+#define CS3910__MAPPEDFILE_H_
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CS3910_HAS_MMAP 1
+#endif
+
+// The read only contents of a file, mapped into memory where supported and
+// read into a buffer elsewhere.
+class MappedFile final
+{
+public:
+    explicit MappedFile(char const* fileName);
+
+    MappedFile(MappedFile const&) = delete;
+
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    ~MappedFile();
+
+    // False when the file could not be opened.
+    bool IsOpen() const noexcept;
+
+    std::string_view Text() const noexcept;
+
+    void const* Data() const noexcept;
+
+    std::size_t Size() const noexcept;
+private:
+    char const* data_;
+
+    std::size_t size_;
+
+    bool open_;
+
+    bool mapped_;
+
+    std::vector<char> buffer_;
+};
+
+inline MappedFile::MappedFile(char const* fileName)
+    : data_{}
+    , size_{}
+    , open_{false}
+    , mapped_{false}
+    , buffer_{}
+{
+#if defined(CS3910_HAS_MMAP)
+    auto const File{ ::open(fileName, O_RDONLY) };
+    if (File < 0)
+        return;
+
+    struct stat status{};
+    if (::fstat(File, &status) == 0)
+    {
+        open_ = true;
+        size_ = static_cast<std::size_t>(status.st_size);
+        if (size_ != 0)
+        {
+            auto const Map{ ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, File, 0) };
+            if (Map != MAP_FAILED)
+            {
+                ::madvise(Map, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<char const*>(Map);
+                mapped_ = true;
+            }
+            else
+                open_ = false;
+        }
+    }
+    ::close(File);
+#else
+    std::ifstream file{ fileName, std::ios::binary };
+    if (!file.is_open())
+        return;
+
+    open_ = true;
+    buffer_.assign(
+        std::istreambuf_iterator<char>{file},
+        std::istreambuf_iterator<char>{});
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+}
+
+inline MappedFile::~MappedFile()
+{
+#if defined(CS3910_HAS_MMAP)
+    if (mapped_)
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+inline bool MappedFile::IsOpen() const noexcept
+{
+    return open_;
+}
+
+inline std::string_view MappedFile::Text() const noexcept
+{
+    return std::string_view{ data_, size_ };
+}
+
+inline void const* MappedFile::Data() const noexcept
+{
+    return data_;
+}
+
+inline std::size_t MappedFile::Size() const noexcept
+{
+    return size_;
+}
+
+#endif // !CS3910__MAPPEDFILE_H_
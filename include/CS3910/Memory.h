@@ -0,0 +1,110 @@
+#ifndef CS3910__MEMORY_H_
+#define CS3910__MEMORY_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// A fixed size array of trivial values, zero filled and aligned to a cache
+// line so rows of a block can start on a vector boundary.
+template<typename T, std::size_t Alignment = 64>
+class AlignedArray final
+{
+    static_assert(std::is_trivial_v<T>, "AlignedArray only holds trivial types.");
+    static_assert(alignof(T) <= Alignment, "The alignment is too small for T.");
+public:
+    using value_type = T;
+
+    AlignedArray() noexcept;
+
+    explicit AlignedArray(std::size_t count);
+
+    constexpr value_type& operator[](std::size_t i) noexcept;
+
+    constexpr value_type const& operator[](std::size_t i) const noexcept;
+
+    value_type* Data() noexcept;
+
+    value_type const* Data() const noexcept;
+
+    constexpr std::size_t Size() const noexcept;
+private:
+    struct Free
+    {
+        void operator()(value_type* data) const noexcept
+        {
+            ::operator delete[](data, std::align_val_t{Alignment});
+        }
+    };
+
+    std::unique_ptr<value_type[], Free> data_;
+
+    std::size_t size_;
+};
+
+// The number of values a row of count values is padded to, so every row of
+// a block stays aligned.
+template<typename T, std::size_t Alignment = 64>
+constexpr std::size_t AlignedStride(std::size_t count) noexcept
+{
+    constexpr std::size_t PerLine{ Alignment / sizeof(T) };
+    static_assert(PerLine != 0 && Alignment % sizeof(T) == 0);
+    return (count + PerLine - 1) / PerLine * PerLine;
+}
+
+template<typename T, std::size_t Alignment>
+AlignedArray<T, Alignment>::AlignedArray() noexcept
+    : data_{}
+    , size_{}
+{
+}
+
+template<typename T, std::size_t Alignment>
+AlignedArray<T, Alignment>::AlignedArray(std::size_t count)
+    : data_{static_cast<value_type*>(::operator new[](
+        count * sizeof(value_type),
+        std::align_val_t{Alignment}))}
+    , size_{count}
+{
+    std::uninitialized_value_construct_n(data_.get(), size_);
+}
+
+template<typename T, std::size_t Alignment>
+constexpr typename AlignedArray<T, Alignment>::value_type&
+AlignedArray<T, Alignment>::operator[](std::size_t i) noexcept
+{
+    assert(i < size_ && "The index must be less than the size.");
+    return data_[i];
+}
+
+template<typename T, std::size_t Alignment>
+constexpr typename AlignedArray<T, Alignment>::value_type const&
+AlignedArray<T, Alignment>::operator[](std::size_t i) const noexcept
+{
+    assert(i < size_ && "The index must be less than the size.");
+    return data_[i];
+}
+
+template<typename T, std::size_t Alignment>
+typename AlignedArray<T, Alignment>::value_type*
+AlignedArray<T, Alignment>::Data() noexcept
+{
+    return data_.get();
+}
+
+template<typename T, std::size_t Alignment>
+typename AlignedArray<T, Alignment>::value_type const*
+AlignedArray<T, Alignment>::Data() const noexcept
+{
+    return data_.get();
+}
+
+template<typename T, std::size_t Alignment>
+constexpr std::size_t AlignedArray<T, Alignment>::Size() const noexcept
+{
+    return size_;
+}
+
+#endif // !CS3910__MEMORY_H_
@@ -0,0 +1,359 @@
+#ifndef CS3910__NEIGHBOURHOOD_H_
+#define CS3910__NEIGHBOURHOOD_H_
+
+#include "Candidates.h"
+#include "Graph.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+enum class NeighbourhoodMove
+{
+    Swap, // Exchange the cities at two positions
+    Opt2 // Reverse the segment between two positions
+};
+
+enum class ImprovementStrategy
+{
+    First, // Apply the first improving move found
+    Best // Apply the best improving move of the whole neighbourhood
+};
+
+// The change in cost caused by swapping the cities at positions i and j of
+// the closed route [first, last). Only the edges around i and j are read.
+template<typename Graph, typename RandomIt>
+auto SwapDelta(
+    Graph const& graph,
+    RandomIt first,
+    RandomIt last,
+    std::size_t i,
+    std::size_t j)
+{
+    auto const Count{ static_cast<std::size_t>(std::distance(first, last)) };
+    assert(i < Count && j < Count);
+    using Cost = CostType<Graph>;
+
+    if (i == j)
+        return Cost{};
+
+    auto const After = [&](std::size_t k)
+    {
+        return k == i ? first[j] : k == j ? first[i] : first[k];
+    };
+
+    // The edges leaving the positions before and at i and j, each counted once
+    std::size_t edges[]{
+        (i + Count - 1) % Count,
+        i,
+        (j + Count - 1) % Count,
+        j };
+    std::sort(std::begin(edges), std::end(edges));
+    auto const EdgesEnd = std::unique(std::begin(edges), std::end(edges));
+
+    Cost delta{};
+    for (auto it = std::begin(edges); it != EdgesEnd; ++it)
+    {
+        auto const Next{ (*it + 1) % Count };
+        delta += Weight(graph, After(*it), After(Next))
+            - Weight(graph, first[*it], first[Next]);
+    }
+    return delta;
+}
+
+// The change in cost caused by reversing the positions (i, j] of the closed
+// route [first, last), which replaces the edges (i, i + 1) and (j, j + 1).
+template<typename Graph, typename RandomIt>
+auto Opt2Delta(
+    Graph const& graph,
+    RandomIt first,
+    RandomIt last,
+    std::size_t i,
+    std::size_t j)
+{
+    auto const Count{ static_cast<std::size_t>(std::distance(first, last)) };
+    assert(i < j && j < Count);
+
+    auto const A{ first[i] };
+    auto const B{ first[i + 1] };
+    auto const C{ first[j] };
+    auto const D{ first[(j + 1) % Count] };
+    return CostType<Graph>{Weight(graph, A, C)} + Weight(graph, B, D)
+        - Weight(graph, A, B) - Weight(graph, C, D);
+}
+
+// Apply the move scored by Opt2Delta.
+template<typename RandomIt>
+void Opt2Reverse(RandomIt first, std::size_t i, std::size_t j)
+{
+    assert(i < j);
+    std::reverse(first + i + 1, first + j + 1);
+}
+
+template<typename Graph, typename RandomIt>
+auto MoveDelta(
+    NeighbourhoodMove move,
+    Graph const& graph,
+    RandomIt first,
+    RandomIt last,
+    std::size_t i,
+    std::size_t j)
+{
+    return move == NeighbourhoodMove::Swap
+        ? SwapDelta(graph, first, last, i, j)
+        : Opt2Delta(graph, first, last, i, j);
+}
+
+template<typename RandomIt>
+void ApplyMove(NeighbourhoodMove move, RandomIt first, std::size_t i, std::size_t j)
+{
+    if (move == NeighbourhoodMove::Swap)
+        std::swap(first[i], first[j]);
+    else
+        Opt2Reverse(first, i, j);
+}
+
+namespace internal
+{
+    // Rounding must not let a move and its inverse both look improving. The
+    // rounding of a change in cost grows with the edges it sums, scale being
+    // a typical edge, and with the precision the weights are stored in.
+    template<typename Graph>
+    CostType<Graph> ImprovementThreshold(CostType<Graph> scale) noexcept
+    {
+        using Value = typename Graph::value_type;
+        if constexpr (std::is_floating_point_v<Value>)
+            return -64 * std::numeric_limits<Value>::epsilon() * std::abs(scale);
+        else
+            return CostType<Graph>{};
+    }
+
+    // The mean edge of the closed route [first, last).
+    template<typename Graph, typename RandomIt>
+    CostType<Graph> EdgeScale(Graph const& graph, RandomIt first, RandomIt last)
+    {
+        auto const Count{ std::distance(first, last) };
+        if (Count < 2)
+            return CostType<Graph>{};
+        CostType<Graph> total{Weight(graph, *first, last[-1])};
+        for (; first + 1 != last; ++first)
+            total += Weight(graph, first[0], first[1]);
+        return total / Count;
+    }
+
+    // The mean distance from a city to its nearest candidate, zero without
+    // candidate lists.
+    template<typename Graph>
+    CostType<Graph> EdgeScale(Graph const& graph, CandidateList const& candidates)
+    {
+        if (candidates.Empty())
+            return CostType<Graph>{};
+        CostType<Graph> total{};
+        for (std::size_t city{}; city < candidates.Count(); ++city)
+            total += Weight(graph, city, *candidates(city));
+        return total / static_cast<std::ptrdiff_t>(candidates.Count());
+    }
+}
+
+// Scan every pair i < j of positions and apply one improving move according to
+// strategy. Each candidate is scored in O(1), so a pass is O(n^2). Returns the
+// change in cost, which is zero at a local optimum.
+template<typename Graph, typename RandomIt>
+auto ImproveOnce(
+    Graph const& graph,
+    RandomIt first,
+    RandomIt last,
+    NeighbourhoodMove move,
+    ImprovementStrategy strategy)
+{
+    auto const Count{ static_cast<std::size_t>(std::distance(first, last)) };
+    using Cost = decltype(MoveDelta(move, graph, first, last, 0, 1));
+
+    auto bestDelta{ internal::ImprovementThreshold<Graph>(
+        internal::EdgeScale(graph, first, last)) };
+    std::size_t bestI{};
+    std::size_t bestJ{};
+    for (std::size_t i{}; i < Count; ++i)
+        for (auto j{ i + 1 }; j < Count; ++j)
+        {
+            auto const Delta{ MoveDelta(move, graph, first, last, i, j) };
+            if (Delta < bestDelta)
+            {
+                bestDelta = Delta;
+                bestI = i;
+                bestJ = j;
+                if (strategy == ImprovementStrategy::First)
+                {
+                    ApplyMove(move, first, bestI, bestJ);
+                    return bestDelta;
+                }
+            }
+        }
+
+    if (bestI == bestJ)
+        return Cost{};
+    ApplyMove(move, first, bestI, bestJ);
+    return bestDelta;
+}
+
+// Repeat ImproveOnce until a local optimum is reached. Returns the total
+// change in cost.
+template<typename Graph, typename RandomIt>
+auto Descend(
+    Graph const& graph,
+    RandomIt first,
+    RandomIt last,
+    NeighbourhoodMove move,
+    ImprovementStrategy strategy)
+{
+    auto total{ ImproveOnce(graph, first, last, move, strategy) };
+    auto delta{ total };
+    while (delta < decltype(delta){})
+    {
+        delta = ImproveOnce(graph, first, last, move, strategy);
+        total += delta;
+    }
+    return total;
+}
+
+namespace internal
+{
+    // Reverse the length positions starting at from, wrapping around the end
+    // of the route, and keep positions in step.
+    template<typename RandomIt, typename PositionIt>
+    void ReverseCyclic(
+        RandomIt first,
+        std::size_t count,
+        std::size_t from,
+        std::size_t length,
+        PositionIt positions)
+    {
+        auto i{ from % count };
+        auto j{ (from + length - 1) % count };
+        for (auto k{ length / 2 }; k != 0; --k)
+        {
+            std::swap(first[i], first[j]);
+            positions[first[i]] = i;
+            positions[first[j]] = j;
+            i = i + 1 == count ? 0 : i + 1;
+            j = j == 0 ? count - 1 : j - 1;
+        }
+    }
+}
+
+// As ImproveOnce, but only consider the moves that bring a city next to one
+// of its candidates, so a pass is O(nk). positions must map each city to its
+// index in [first, last) and is kept up to date.
+template<typename Graph, typename RandomIt, typename PositionIt>
+auto ImproveOnce(
+    Graph const& graph,
+    CandidateList const& candidates,
+    RandomIt first,
+    RandomIt last,
+    PositionIt positions,
+    NeighbourhoodMove move,
+    ImprovementStrategy strategy)
+{
+    auto const Count{ static_cast<std::size_t>(std::distance(first, last)) };
+    assert(candidates.Count() == Count);
+    using Cost = decltype(MoveDelta(move, graph, first, last, 0, 1));
+
+    auto bestDelta{ internal::ImprovementThreshold<Graph>(
+        internal::EdgeScale(graph, first, last)) };
+    std::size_t bestI{};
+    std::size_t bestJ{};
+    auto const Consider = [&](std::size_t i, std::size_t j)
+    {
+        if (j < i)
+            std::swap(i, j);
+        if (i == j)
+            return false;
+        auto const Delta{ MoveDelta(move, graph, first, last, i, j) };
+        if (!(Delta < bestDelta))
+            return false;
+        bestDelta = Delta;
+        bestI = i;
+        bestJ = j;
+        return strategy == ImprovementStrategy::First;
+    };
+
+    auto const Search = [&]()
+    {
+        for (std::size_t i{}; i < Count; ++i)
+        {
+            auto const A{ first[i] };
+            auto const Next{ i + 1 == Count ? 0 : i + 1 };
+            auto const Prev{ i == 0 ? Count - 1 : i - 1 };
+            auto const NextWeight{ Weight(graph, A, first[Next]) };
+            auto const PrevWeight{ Weight(graph, first[Prev], A) };
+            auto const Candidates{ candidates(A) };
+            for (auto k{ Candidates }; k != Candidates + candidates.Size(); ++k)
+            {
+                auto const J{ static_cast<std::size_t>(positions[*k]) };
+                if (move == NeighbourhoodMove::Swap)
+                {
+                    // Bring the candidate next to A
+                    if (Consider(Next, J))
+                        return;
+                    continue;
+                }
+
+                // An improving 2-opt move must shorten one of the edges at A,
+                // and the candidates are sorted by distance.
+                auto const CandidateWeight{ Weight(graph, A, *k) };
+                if (!(CandidateWeight < NextWeight) && !(CandidateWeight < PrevWeight))
+                    break;
+                if (CandidateWeight < NextWeight && Consider(i, J))
+                    return;
+                if (CandidateWeight < PrevWeight && Consider(Prev, J == 0 ? Count - 1 : J - 1))
+                    return;
+            }
+        }
+    };
+
+    Search();
+    if (bestI == bestJ)
+        return Cost{};
+
+    if (move == NeighbourhoodMove::Swap)
+    {
+        std::swap(first[bestI], first[bestJ]);
+        positions[first[bestI]] = bestI;
+        positions[first[bestJ]] = bestJ;
+    }
+    else if (2 * (bestJ - bestI) <= Count)
+        internal::ReverseCyclic(first, Count, bestI + 1, bestJ - bestI, positions);
+    else // Reversing the rest of the route gives the same tour
+        internal::ReverseCyclic(first, Count, bestJ + 1, Count - (bestJ - bestI), positions);
+    return bestDelta;
+}
+
+// As Descend, restricted to candidate moves. positions is a buffer of at
+// least Count entries and is filled here.
+template<typename Graph, typename RandomIt, typename PositionIt>
+auto Descend(
+    Graph const& graph,
+    CandidateList const& candidates,
+    RandomIt first,
+    RandomIt last,
+    PositionIt positions,
+    NeighbourhoodMove move,
+    ImprovementStrategy strategy)
+{
+    for (auto it{ first }; it != last; ++it)
+        positions[*it] = std::distance(first, it);
+
+    auto total{ ImproveOnce(graph, candidates, first, last, positions, move, strategy) };
+    auto delta{ total };
+    while (delta < decltype(delta){})
+    {
+        delta = ImproveOnce(graph, candidates, first, last, positions, move, strategy);
+        total += delta;
+    }
+    return total;
+}
+
+#endif // !CS3910__NEIGHBOURHOOD_H_
@@ -0,0 +1,345 @@
+#ifndef CS3910__PACKEDPROBLEM_H_
+#define CS3910__PACKEDPROBLEM_H_
+
+#include "Candidates.h"
+#include "Distance.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// How the distance matrix of a packed problem is stored.
+enum class PackedMatrix : std::uint32_t
+{
+    None,
+    Double, // The values of a SymmetricMatrix<double>
+    Float // The same rounded to float, in half the space
+};
+
+// The start of a packed problem, a problem preprocessed into one file that
+// is mapped and used as it is. Starting a solver then costs no parsing and
+// no O(n^2) distances, and every process solving the problem shares one copy
+// in the page cache. The header is followed by sections at the offsets it
+// gives, each aligned to 64 bytes: the x and then the y coordinates as
+// double, count + 1 offsets into the names, the names, count candidate lists
+// of uint32 and the matrix. The file is in native byte order.
+struct PackedHeader
+{
+    static constexpr char MAGIC[8]{ 'C', 'S', '3', '9', '1', '0', 'T', 'S' };
+
+    static constexpr std::uint32_t VERSION{ 1 };
+
+    static constexpr std::uint32_t ENDIAN_CHECK{ 0x01020304 };
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder; // ENDIAN_CHECK as the writer stored it
+    std::uint32_t metric;
+    std::uint32_t matrix;
+    std::uint64_t count;
+    std::uint64_t candidates; // Per node, zero when there are none
+    std::uint64_t xs;
+    std::uint64_t ys;
+    std::uint64_t nameOffsets;
+    std::uint64_t names;
+    std::uint64_t candidateData;
+    std::uint64_t matrixData;
+};
+
+// A packed problem read in place from a mapped file.
+class PackedProblem final
+{
+public:
+    // The problem in file, none when it is not a packed problem of this
+    // version and byte order, it is cut short or its metric, name offsets or
+    // candidates are out of range. The distances are trusted.
+    static std::optional<PackedProblem> Open(std::shared_ptr<MappedFile const> file);
+
+    std::size_t Count() const noexcept;
+
+    Metric DistanceMetric() const noexcept;
+
+    double X(std::size_t node) const noexcept;
+
+    double Y(std::size_t node) const noexcept;
+
+    std::string_view Name(std::size_t node) const noexcept;
+
+    // The number of candidates stored per node.
+    std::size_t CandidateCount() const noexcept;
+
+    // The stored candidate lists cut to k per node, k at most CandidateCount.
+    CandidateList Candidates(std::size_t k) const noexcept;
+
+    // The stored matrix, null unless its values are of type T.
+    template<typename T>
+    T const* Matrix() const noexcept;
+
+    // The mapping, which views into the problem must keep alive.
+    std::shared_ptr<MappedFile const> const& File() const noexcept;
+private:
+    std::shared_ptr<MappedFile const> file_;
+
+    PackedHeader header_;
+
+    PackedProblem(std::shared_ptr<MappedFile const> file, PackedHeader const& header) noexcept;
+
+    template<typename T>
+    T const* At(std::uint64_t offset) const noexcept;
+};
+
+// Write the nodes [first, last), which have name, x and y members, with
+// their candidate lists and, unless matrixType is None, the values at matrix
+// in the layout of SymmetricMatrix and of the type given. False when the
+// stream failed.
+template<typename ForwardIt>
+bool WritePackedProblem(
+    std::ostream& outs,
+    ForwardIt first,
+    ForwardIt last,
+    Metric metric,
+    CandidateList const& candidates,
+    PackedMatrix matrixType,
+    void const* matrix);
+
+namespace internal
+{
+    constexpr std::uint64_t PackedAlign(std::uint64_t offset) noexcept
+    {
+        return (offset + 63) / 64 * 64;
+    }
+
+    constexpr std::uint64_t PackedMatrixSize(
+        PackedMatrix matrix,
+        std::uint64_t count)
+        noexcept
+    {
+        auto const Values{ count * (count + 1) / 2 };
+        switch (matrix)
+        {
+        case PackedMatrix::Double:
+            return Values * sizeof(double);
+        case PackedMatrix::Float:
+            return Values * sizeof(float);
+        default:
+            return 0;
+        }
+    }
+}
+
+inline std::optional<PackedProblem> PackedProblem::Open(
+    std::shared_ptr<MappedFile const> file)
+{
+    PackedHeader header{};
+    if (!file->IsOpen() || file->Size() < sizeof(header))
+        return std::nullopt;
+    std::memcpy(&header, file->Data(), sizeof(header));
+    if (std::memcmp(header.magic, PackedHeader::MAGIC, sizeof(header.magic)) != 0
+        || header.version != PackedHeader::VERSION
+        || header.byteOrder != PackedHeader::ENDIAN_CHECK
+        || static_cast<std::uint32_t>(Metric::Att) < header.metric
+        || PackedMatrix::Float < static_cast<PackedMatrix>(header.matrix))
+        return std::nullopt;
+
+    // Every section must lie inside the file
+    auto const Size{ file->Size() };
+    auto const Count{ header.count };
+    auto const Fits = [=](std::uint64_t offset, std::uint64_t length)
+    {
+        return offset % 64 == 0 && offset <= Size && length <= Size - offset;
+    };
+    auto const ValueSize{ internal::PackedMatrixSize(
+        static_cast<PackedMatrix>(header.matrix),
+        1) };
+    if (Size / sizeof(double) < Count
+        || std::numeric_limits<CandidateList::value_type>::max() <= Count
+        || !Fits(header.xs, Count * sizeof(double))
+        || !Fits(header.ys, Count * sizeof(double))
+        || !Fits(header.nameOffsets, (Count + 1) * sizeof(std::uint64_t))
+        || Size / sizeof(std::uint32_t) / std::max<std::uint64_t>(Count, 1) < header.candidates
+        || !Fits(header.candidateData, Count * header.candidates * sizeof(std::uint32_t))
+        || !Fits(header.matrixData, 0)
+        || (ValueSize != 0 && (Size - header.matrixData) / ValueSize < Count * (Count + 1) / 2))
+        return std::nullopt;
+
+    // Names and candidates are read without checks once the file is open
+    PackedProblem problem{std::move(file), header};
+    auto const Offsets{ problem.At<std::uint64_t>(header.nameOffsets) };
+    if (!Fits(header.names, Offsets[Count]))
+        return std::nullopt;
+    for (std::uint64_t i{}; i < Count; ++i)
+        if (Offsets[i + 1] < Offsets[i])
+            return std::nullopt;
+    auto const Candidates{ problem.At<CandidateList::value_type>(header.candidateData) };
+    if (!std::all_of(
+        Candidates,
+        Candidates + Count * header.candidates,
+        [=](auto const node){ return node < Count; }))
+        return std::nullopt;
+    return problem;
+}
+
+inline PackedProblem::PackedProblem(
+    std::shared_ptr<MappedFile const> file,
+    PackedHeader const& header)
+    noexcept
+    : file_{std::move(file)}
+    , header_{header}
+{
+}
+
+inline std::size_t PackedProblem::Count() const noexcept
+{
+    return header_.count;
+}
+
+inline Metric PackedProblem::DistanceMetric() const noexcept
+{
+    return static_cast<Metric>(header_.metric);
+}
+
+inline double PackedProblem::X(std::size_t node) const noexcept
+{
+    assert(node < Count());
+    return At<double>(header_.xs)[node];
+}
+
+inline double PackedProblem::Y(std::size_t node) const noexcept
+{
+    assert(node < Count());
+    return At<double>(header_.ys)[node];
+}
+
+inline std::string_view PackedProblem::Name(std::size_t node) const noexcept
+{
+    assert(node < Count());
+    auto const Offsets{ At<std::uint64_t>(header_.nameOffsets) };
+    return std::string_view{
+        At<char>(header_.names) + Offsets[node],
+        Offsets[node + 1] - Offsets[node] };
+}
+
+inline std::size_t PackedProblem::CandidateCount() const noexcept
+{
+    return header_.candidates;
+}
+
+inline CandidateList PackedProblem::Candidates(std::size_t k) const noexcept
+{
+    assert(k <= CandidateCount());
+    return CandidateList{
+        file_,
+        At<CandidateList::value_type>(header_.candidateData),
+        Count(),
+        k,
+        CandidateCount()};
+}
+
+template<typename T>
+T const* PackedProblem::Matrix() const noexcept
+{
+    auto const Stored{ static_cast<PackedMatrix>(header_.matrix) };
+    if constexpr (std::is_same_v<T, double>)
+        return Stored == PackedMatrix::Double ? At<T>(header_.matrixData) : nullptr;
+    else if constexpr (std::is_same_v<T, float>)
+        return Stored == PackedMatrix::Float ? At<T>(header_.matrixData) : nullptr;
+    else
+        return nullptr;
+}
+
+inline std::shared_ptr<MappedFile const> const& PackedProblem::File() const noexcept
+{
+    return file_;
+}
+
+template<typename T>
+T const* PackedProblem::At(std::uint64_t offset) const noexcept
+{
+    return reinterpret_cast<T const*>(
+        static_cast<char const*>(file_->Data()) + offset);
+}
+
+template<typename ForwardIt>
+bool WritePackedProblem(
+    std::ostream& outs,
+    ForwardIt first,
+    ForwardIt last,
+    Metric metric,
+    CandidateList const& candidates,
+    PackedMatrix matrixType,
+    void const* matrix)
+{
+    using internal::PackedAlign;
+    assert(matrixType == PackedMatrix::None || matrix != nullptr);
+
+    std::vector<double> xs{};
+    std::vector<double> ys{};
+    std::vector<std::uint64_t> nameOffsets{ 0 };
+    std::vector<char> names{};
+    for (; first != last; ++first)
+    {
+        xs.push_back(first->x);
+        ys.push_back(first->y);
+        names.insert(names.end(), first->name.begin(), first->name.end());
+        nameOffsets.push_back(names.size());
+    }
+    auto const Count{ xs.size() };
+    assert(candidates.Empty() || candidates.Count() == Count);
+
+    PackedHeader header{};
+    std::memcpy(header.magic, PackedHeader::MAGIC, sizeof(header.magic));
+    header.version = PackedHeader::VERSION;
+    header.byteOrder = PackedHeader::ENDIAN_CHECK;
+    header.metric = static_cast<std::uint32_t>(metric);
+    header.matrix = static_cast<std::uint32_t>(matrixType);
+    header.count = Count;
+    header.candidates = candidates.Size();
+    header.xs = PackedAlign(sizeof(header));
+    header.ys = PackedAlign(header.xs + Count * sizeof(double));
+    header.nameOffsets = PackedAlign(header.ys + Count * sizeof(double));
+    header.names = PackedAlign(header.nameOffsets + (Count + 1) * sizeof(std::uint64_t));
+    header.candidateData = PackedAlign(header.names + names.size());
+    header.matrixData = PackedAlign(
+        header.candidateData + Count * candidates.Size() * sizeof(std::uint32_t));
+
+    std::uint64_t position{};
+    auto const Write = [&](std::uint64_t offset, void const* data, std::uint64_t size)
+    {
+        static constexpr char Zeros[64]{};
+        assert(position <= offset && offset - position < sizeof(Zeros));
+        outs.write(Zeros, offset - position);
+        outs.write(static_cast<char const*>(data), size);
+        position = offset + size;
+    };
+    Write(0, &header, sizeof(header));
+    Write(header.xs, xs.data(), Count * sizeof(double));
+    Write(header.ys, ys.data(), Count * sizeof(double));
+    Write(header.nameOffsets, nameOffsets.data(), (Count + 1) * sizeof(std::uint64_t));
+    Write(header.names, names.data(), names.size());
+    for (std::size_t i{}; i < Count && !candidates.Empty(); ++i)
+        Write(
+            i == 0 ? header.candidateData : position,
+            candidates(i),
+            candidates.Size() * sizeof(std::uint32_t));
+    if (matrixType != PackedMatrix::None)
+        Write(
+            header.matrixData,
+            matrix,
+            internal::PackedMatrixSize(matrixType, Count));
+    else
+        Write(header.matrixData, nullptr, 0);
+    return static_cast<bool>(outs.flush());
+}
+
+#endif // !CS3910__PACKEDPROBLEM_H_
@@ -1,41 +1,227 @@
 #ifndef CS3910__PHEROMONE_H_
 #define CS3910__PHEROMONE_H_
 
+#include "Candidates.h"
+#include "Executor.h"
 #include "Graph.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
 
+// Pheromone levels that many ants can deposit into at the same time. Deposits
+// are gathered with atomic adds in a separate matrix, so they never race with
+// ants reading the levels, and Update folds them in together with evaporation
+// in a single parallel pass. The deposits are summed in fixed point, which
+// unlike floating point gives the same sum whatever order the ants add in.
 template<typename T>
-T& Pheromone(
-    AdjacencyMatrix<T>& graph,
+class PheromoneStore final
+{
+public:
+    using value_type = T;
+
+    // Edges handed to a thread at a time by the whole matrix passes
+    static constexpr std::size_t UPDATE_GRAIN{ 4096 };
+
+    // Deposits are rounded to multiples of 1 / DEPOSIT_SCALE
+    static constexpr value_type DEPOSIT_SCALE{ 4294967296.0 };
+
+    explicit PheromoneStore(std::size_t count);
+
+    // Set every level and discard pending deposits.
+    void Reset(value_type level);
+
+    constexpr value_type operator()(std::size_t x, std::size_t y) const noexcept;
+
+    constexpr std::size_t Count() const noexcept;
+
+    constexpr SymmetricMatrix<T> const& Levels() const noexcept;
+
+    // Add amount to every edge of the closed route [first, last). Safe to call
+    // from many threads at once.
+    template<typename RandomIt>
+    void Deposit(value_type amount, RandomIt first, RandomIt last) noexcept;
+
+    // Scale every level by rate and add the deposits made since the last
+    // update. Must not run concurrently with Deposit.
+    void Update(value_type rate, Executor& executor);
+private:
+    SymmetricMatrix<T> levels_;
+
+    SymmetricMatrix<std::atomic<std::int64_t>> deposits_;
+};
+
+template<typename T>
+PheromoneStore<T>::PheromoneStore(std::size_t count)
+    : levels_{count}
+    , deposits_{count}
+{
+}
+
+template<typename T>
+void PheromoneStore<T>::Reset(value_type level)
+{
+    std::fill_n(levels_.Data(), levels_.Size(), level);
+    std::for_each(
+        deposits_.Data(),
+        deposits_.Data() + deposits_.Size(),
+        [](auto& x) noexcept
+        {
+            x.store(0, std::memory_order_relaxed);
+        });
+}
+
+template<typename T>
+constexpr typename PheromoneStore<T>::value_type
+PheromoneStore<T>::operator()(
     std::size_t x,
     std::size_t y)
-    noexcept
+    const noexcept
+{
+    return levels_(x, y);
+}
+
+template<typename T>
+constexpr std::size_t PheromoneStore<T>::Count() const noexcept
 {
-    if (x < y)
-        std::swap(x, y);
-    return graph(x, y);
+    return levels_.Count();
 }
 
 template<typename T>
-void DecayPheromone(AdjacencyMatrix<T>& graph, T rate)
+constexpr SymmetricMatrix<T> const& PheromoneStore<T>::Levels() const noexcept
 {
-    for (std::size_t i{ 1 }; i < graph.Count(); ++i)
-        for (auto j{ i + 1 }; j < graph.Count(); ++j)
-            Pheromone(graph, i, j) *= rate;
+    return levels_;
 }
 
-template<
-    typename T,
-    typename RandomIt>
-void IncreasePheromone(
-    AdjacencyMatrix<T>& graph,
-    double amount,
+template<typename T>
+template<typename RandomIt>
+void PheromoneStore<T>::Deposit(
+    value_type amount,
     RandomIt first,
     RandomIt last)
     noexcept
 {
-    Pheromone(graph, *first, last[-1]) += amount;
+    auto const Amount{ std::llround(amount * DEPOSIT_SCALE) };
+    deposits_(*first, last[-1]).fetch_add(Amount, std::memory_order_relaxed);
     for (; first + 1 != last; ++first)
-        Pheromone(graph, first[0], first[1]) += amount;
+        deposits_(first[0], first[1]).fetch_add(Amount, std::memory_order_relaxed);
+}
+
+template<typename T>
+void PheromoneStore<T>::Update(value_type rate, Executor& executor)
+{
+    auto const Levels{ levels_.Data() };
+    auto const Deposits{ deposits_.Data() };
+    executor.ParallelFor(
+        0,
+        deposits_.Size(),
+        [=](auto i) noexcept
+        {
+            Levels[i] = rate * Levels[i]
+                + Deposits[i].exchange(0, std::memory_order_relaxed) / DEPOSIT_SCALE;
+        },
+        UPDATE_GRAIN);
+}
+
+template<typename T>
+T Pheromone(PheromoneStore<T> const& store, std::size_t x, std::size_t y) noexcept
+{
+    return store(x, y);
+}
+
+// The heuristic desire weight(x, y)^-b of every edge, computed once per run.
+template<typename T, typename Graph>
+SymmetricMatrix<T> HeuristicInfo(Graph const& graph, T b)
+{
+    SymmetricMatrix<T> heuristic{graph.Count()};
+    for (std::size_t x{}; x < graph.Count(); ++x)
+    {
+        for (std::size_t y{}; y < x; ++y)
+            heuristic(x, y) = std::pow(Weight(graph, x, y), -b);
+        heuristic(x, x) = T{};
+    }
+    return heuristic;
+}
+
+// The heuristic desire towards the k-th candidate c of every city x,
+// weight(x, c)^-b at x * candidates.Size() + k. Only the n * k candidate
+// edges are weighed.
+template<typename T, typename Graph>
+std::vector<T> HeuristicInfo(Graph const& graph, CandidateList const& candidates, T b)
+{
+    assert(candidates.Count() == graph.Count());
+    auto const Size{ candidates.Size() };
+    std::vector<T> heuristic(candidates.Count() * Size);
+    for (std::size_t x{}; x < candidates.Count(); ++x)
+        for (std::size_t k{}; k < Size; ++k)
+            heuristic[x * Size + k] = std::pow(T(Weight(graph, x, candidates(x)[k])), -b);
+    return heuristic;
+}
+
+// The choice value pheromone^a * weight^-b of an edge that has no entry in
+// the tables below, computed when it is needed.
+template<typename T>
+T ChoiceInfo(T pheromone, T weight, T a, T b) noexcept
+{
+    return (a == T{1} ? pheromone : std::pow(pheromone, a)) * std::pow(weight, -b);
+}
+
+// Set choice(x, y) = pheromone(x, y)^a * heuristic(x, y) for every edge, so
+// constructing a route only needs lookups.
+template<typename T>
+void UpdateChoiceInfo(
+    SymmetricMatrix<T>& choice,
+    SymmetricMatrix<T> const& pheromone,
+    SymmetricMatrix<T> const& heuristic,
+    T a,
+    Executor& executor)
+{
+    assert(choice.Count() == pheromone.Count());
+    assert(choice.Count() == heuristic.Count());
+    auto const Levels{ pheromone.Data() };
+    auto const Desires{ heuristic.Data() };
+    auto const Choices{ choice.Data() };
+    executor.ParallelFor(
+        0,
+        pheromone.Size(),
+        [=](auto i) noexcept
+        {
+            Choices[i] = (a == T{1} ? Levels[i] : std::pow(Levels[i], a)) * Desires[i];
+        },
+        PheromoneStore<T>::UPDATE_GRAIN);
+}
+
+// As above for the candidate edges only, in the layout of the candidate
+// HeuristicInfo.
+template<typename T>
+void UpdateChoiceInfo(
+    std::vector<T>& choice,
+    SymmetricMatrix<T> const& pheromone,
+    CandidateList const& candidates,
+    std::vector<T> const& heuristic,
+    T a,
+    Executor& executor)
+{
+    assert(candidates.Count() == pheromone.Count());
+    assert(heuristic.size() == candidates.Count() * candidates.Size());
+    auto const Size{ candidates.Size() };
+    choice.resize(heuristic.size());
+    executor.ParallelFor(
+        0,
+        candidates.Count(),
+        [&](auto x) noexcept
+        {
+            auto const Candidates{ candidates(x) };
+            for (std::size_t k{}; k < Size; ++k)
+            {
+                auto const Level{ pheromone(x, Candidates[k]) };
+                choice[x * Size + k] = (a == T{1} ? Level : std::pow(Level, a))
+                    * heuristic[x * Size + k];
+            }
+        },
+        PheromoneStore<T>::UPDATE_GRAIN / Size + 1);
 }
 
 #endif // !CS3910__PHEROMONE_H_
@@ -0,0 +1,129 @@
+#ifndef CS3910__QUEUE_H_
+#define CS3910__QUEUE_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// A bounded lock-free queue for many producers and many consumers, after
+// Dmitry Vyukov. Every cell carries a sequence number telling whether it is
+// ready to be written or read in the current lap, so a push or pop is one
+// compare and swap on the shared position.
+template<typename T>
+class BoundedQueue final
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Values are copied into cells.");
+public:
+    using value_type = T;
+
+    // capacity is rounded up to a power of two.
+    explicit BoundedQueue(std::size_t capacity);
+
+    BoundedQueue(BoundedQueue const&) = delete;
+
+    BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+    // False when the queue is full.
+    bool TryPush(value_type const& value) noexcept;
+
+    // False when the queue is empty.
+    bool TryPop(value_type& value) noexcept;
+
+    constexpr std::size_t Capacity() const noexcept;
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        value_type value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+
+    std::size_t mask_;
+
+    // Producers and consumers do not share a cache line
+    alignas(64) std::atomic<std::size_t> pushPosition_;
+
+    alignas(64) std::atomic<std::size_t> popPosition_;
+};
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(std::size_t capacity)
+    : cells_{}
+    , mask_{1}
+    , pushPosition_{0}
+    , popPosition_{0}
+{
+    while (mask_ < capacity)
+        mask_ <<= 1;
+    cells_ = std::make_unique<Cell[]>(mask_);
+    for (std::size_t i{}; i < mask_; ++i)
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    --mask_;
+}
+
+template<typename T>
+bool BoundedQueue<T>::TryPush(value_type const& value) noexcept
+{
+    auto position{ pushPosition_.load(std::memory_order_relaxed) };
+    for (;;)
+    {
+        auto& cell{ cells_[position & mask_] };
+        auto const Sequence{ cell.sequence.load(std::memory_order_acquire) };
+        auto const Lag{ static_cast<std::ptrdiff_t>(Sequence - position) };
+        if (Lag == 0)
+        {
+            if (pushPosition_.compare_exchange_weak(
+                position,
+                position + 1,
+                std::memory_order_relaxed))
+            {
+                cell.value = value;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (Lag < 0) // The cell still holds a value from the last lap
+            return false;
+        else
+            position = pushPosition_.load(std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+bool BoundedQueue<T>::TryPop(value_type& value) noexcept
+{
+    auto position{ popPosition_.load(std::memory_order_relaxed) };
+    for (;;)
+    {
+        auto& cell{ cells_[position & mask_] };
+        auto const Sequence{ cell.sequence.load(std::memory_order_acquire) };
+        auto const Lag{ static_cast<std::ptrdiff_t>(Sequence - (position + 1)) };
+        if (Lag == 0)
+        {
+            if (popPosition_.compare_exchange_weak(
+                position,
+                position + 1,
+                std::memory_order_relaxed))
+            {
+                value = cell.value;
+                cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (Lag < 0) // Nothing has been pushed to the cell yet
+            return false;
+        else
+            position = popPosition_.load(std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+constexpr std::size_t BoundedQueue<T>::Capacity() const noexcept
+{
+    return mask_ + 1;
+}
+
+#endif // !CS3910__QUEUE_H_
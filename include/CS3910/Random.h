@@ -0,0 +1,185 @@
+#ifndef CS3910__RANDOM_H_
+#define CS3910__RANDOM_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <utility>
+
+// The master seed of a run, drawn from std::random_device when seed is zero.
+inline std::uint64_t MasterSeed(std::uint64_t seed)
+{
+    if (seed != 0)
+        return seed;
+    std::random_device device{};
+    return std::uint64_t{device()} << 32 | device();
+}
+
+// The master seed of a run of a tool: CS3910_SEED when set, else drawn. It is
+// written to std::cerr, so any run can be repeated with CS3910_SEED.
+inline std::uint64_t MasterSeedFromEnvironment()
+{
+    std::uint64_t seed{};
+    if (auto const Seed{ std::getenv("CS3910_SEED") })
+        seed = std::strtoull(Seed, nullptr, 10);
+    seed = MasterSeed(seed);
+    std::cerr << "Seed " << seed << '\n';
+    return seed;
+}
+
+// The counter based Philox4x32-10 generator of Salmon et al. Every output
+// is a function of the seed, the stream and its position alone, so each
+// ant, particle or island can be given its own stream of one master seed
+// and the results do not depend on which thread runs it.
+class Philox4x32 final
+{
+public:
+    using result_type = std::uint32_t;
+
+    explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) noexcept;
+
+    void seed(std::uint64_t seed, std::uint64_t stream = 0) noexcept;
+
+    result_type operator()() noexcept;
+
+    static constexpr result_type min() noexcept;
+
+    static constexpr result_type max() noexcept;
+private:
+    std::uint32_t key_[2];
+
+    std::uint32_t counter_[4]; // The block and then the stream
+
+    std::uint32_t block_[4];
+
+    std::size_t next_;
+
+    void Generate() noexcept;
+};
+
+inline Philox4x32::Philox4x32(std::uint64_t seed, std::uint64_t stream) noexcept
+{
+    this->seed(seed, stream);
+}
+
+inline void Philox4x32::seed(std::uint64_t seed, std::uint64_t stream) noexcept
+{
+    key_[0] = static_cast<std::uint32_t>(seed);
+    key_[1] = static_cast<std::uint32_t>(seed >> 32);
+    counter_[0] = 0;
+    counter_[1] = 0;
+    counter_[2] = static_cast<std::uint32_t>(stream);
+    counter_[3] = static_cast<std::uint32_t>(stream >> 32);
+    next_ = 4;
+}
+
+inline Philox4x32::result_type Philox4x32::operator()() noexcept
+{
+    if (next_ == 4)
+    {
+        Generate();
+        next_ = 0;
+    }
+    return block_[next_++];
+}
+
+constexpr Philox4x32::result_type Philox4x32::min() noexcept
+{
+    return std::numeric_limits<result_type>::min();
+}
+
+constexpr Philox4x32::result_type Philox4x32::max() noexcept
+{
+    return std::numeric_limits<result_type>::max();
+}
+
+inline void Philox4x32::Generate() noexcept
+{
+    constexpr std::uint64_t M0{ 0xD2511F53 };
+    constexpr std::uint64_t M1{ 0xCD9E8D57 };
+    constexpr std::uint32_t W0{ 0x9E3779B9 };
+    constexpr std::uint32_t W1{ 0xBB67AE85 };
+
+    std::uint32_t x[4]{ counter_[0], counter_[1], counter_[2], counter_[3] };
+    std::uint32_t k[2]{ key_[0], key_[1] };
+    for (int round{}; round < 10; ++round)
+    {
+        auto const P0{ M0 * x[0] };
+        auto const P1{ M1 * x[2] };
+        std::uint32_t const Next[4]{
+            static_cast<std::uint32_t>(P1 >> 32) ^ x[1] ^ k[0],
+            static_cast<std::uint32_t>(P1),
+            static_cast<std::uint32_t>(P0 >> 32) ^ x[3] ^ k[1],
+            static_cast<std::uint32_t>(P0) };
+        x[0] = Next[0];
+        x[1] = Next[1];
+        x[2] = Next[2];
+        x[3] = Next[3];
+        k[0] += W0;
+        k[1] += W1;
+    }
+    block_[0] = x[0];
+    block_[1] = x[1];
+    block_[2] = x[2];
+    block_[3] = x[3];
+
+    if (++counter_[0] == 0)
+        ++counter_[1];
+}
+
+// The draws below give the same values with every standard library, unlike
+// the std distributions. They take generators of full 32 bit words.
+
+template<typename RngT>
+constexpr void AssertWordGenerator() noexcept
+{
+    static_assert(RngT::min() == 0 && RngT::max() == 0xFFFFFFFF,
+        "The generator must give uniform 32 bit words.");
+}
+
+// Uniform in [0, 1) with 53 random bits.
+template<typename RngT>
+double UniformUnit(RngT& rng) noexcept
+{
+    AssertWordGenerator<RngT>();
+    auto const High{ std::uint64_t{rng()} };
+    auto const Word{ High << 32 | rng() };
+    return static_cast<double>(Word >> 11) * 0x1.0p-53;
+}
+
+// Uniform in [0, count) by Lemire's multiply and reject, count must be less
+// than 2^32.
+template<typename RngT>
+std::size_t UniformIndex(RngT& rng, std::size_t count) noexcept
+{
+    AssertWordGenerator<RngT>();
+    assert(count != 0 && count <= 0xFFFFFFFF);
+    auto const Range{ static_cast<std::uint32_t>(count) };
+    auto product{ std::uint64_t{rng()} * Range };
+    if (static_cast<std::uint32_t>(product) < Range)
+    {
+        auto const Threshold{ static_cast<std::uint32_t>(-Range) % Range };
+        while (static_cast<std::uint32_t>(product) < Threshold)
+            product = std::uint64_t{rng()} * Range;
+    }
+    return static_cast<std::size_t>(product >> 32);
+}
+
+// Fisher-Yates shuffle of [first, last).
+template<typename RandomIt, typename RngT>
+void Shuffle(RandomIt first, RandomIt last, RngT& rng) noexcept
+{
+    auto const Count{ static_cast<std::size_t>(std::distance(first, last)) };
+    for (auto i{ Count }; i > 1; --i)
+    {
+        using std::swap;
+        swap(first[i - 1], first[UniformIndex(rng, i)]);
+    }
+}
+
+#endif // !CS3910__RANDOM_H_
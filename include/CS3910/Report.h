@@ -0,0 +1,331 @@
+#ifndef CS3910__REPORT_H_
+#define CS3910__REPORT_H_
+
+#include "Queue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+enum class ReportFormat
+{
+    Text, // iteration: value [solution]
+    Csv, // seconds,iteration,source,value,solution
+    JsonLines, // One object per line with the same fields
+    Off // Nothing is written
+};
+
+struct ReportOptions
+{
+    ReportFormat format;
+    std::chrono::milliseconds interval; // Least time between two lines
+    std::size_t capacity; // Improvements that may wait for the writer
+
+    // Read CS3910_REPORT (text, csv, jsonl or off) and CS3910_REPORT_INTERVAL
+    // in milliseconds.
+    static ReportOptions FromEnvironment() noexcept;
+};
+
+// Reports improvements to the best solution from a background thread, so
+// the search threads never wait on the console. Publish copies the solution
+// into a free slot and queues it; the writer formats the queued solutions
+// and hands the slots back. When improvements come faster than the interval
+// only the latest is written, and when every slot is taken they are dropped.
+template<typename V>
+class Reporter final
+{
+    static_assert(std::is_trivially_copyable_v<V>, "Solutions are copied into slots.");
+public:
+    using value_type = V;
+
+    // Names a solution element, the value itself is written when empty.
+    using Label = std::function<std::string_view(value_type const&)>;
+
+    // Report solutions of size elements to std::cout, which is left to the
+    // reports alone: other output of the tools goes to std::cerr.
+    explicit Reporter(
+        std::size_t size,
+        Label label = {},
+        ReportOptions const& options = ReportOptions::FromEnvironment());
+
+    Reporter(Reporter const&) = delete;
+
+    Reporter& operator=(Reporter const&) = delete;
+
+    ~Reporter();
+
+    // Queue the solution [first, first + size) reaching value at iteration,
+    // found by source. Safe to call from many threads at once, never blocks
+    // and false when the improvement was dropped.
+    template<typename InputIt>
+    bool Publish(
+        std::size_t iteration,
+        double value,
+        InputIt first,
+        std::size_t source = 0) noexcept;
+
+    // Write everything published so far and stop the writer.
+    void Close();
+
+    std::size_t Dropped() const noexcept;
+private:
+    struct Event
+    {
+        double seconds;
+        std::size_t iteration;
+        double value;
+        std::size_t source;
+        std::size_t slot;
+    };
+
+    std::size_t size_;
+
+    Label label_;
+
+    ReportOptions options_;
+
+    std::unique_ptr<value_type[]> solutions_;
+
+    BoundedQueue<std::size_t> free_;
+
+    BoundedQueue<Event> full_;
+
+    std::chrono::steady_clock::time_point start_;
+
+    std::atomic<std::size_t> dropped_;
+
+    std::atomic<bool> stop_;
+
+    std::thread writer_;
+
+    void Write();
+
+    void Format(std::ostream& outs, Event const& event) const;
+
+    void FormatSolution(std::ostream& outs, Event const& event, bool json) const;
+};
+
+inline ReportOptions ReportOptions::FromEnvironment() noexcept
+{
+    ReportOptions options{ReportFormat::Text, std::chrono::milliseconds{0}, 64};
+    if (auto const Format{ std::getenv("CS3910_REPORT") })
+    {
+        if (std::strcmp(Format, "csv") == 0)
+            options.format = ReportFormat::Csv;
+        else if (std::strcmp(Format, "jsonl") == 0)
+            options.format = ReportFormat::JsonLines;
+        else if (std::strcmp(Format, "off") == 0)
+            options.format = ReportFormat::Off;
+    }
+    if (auto const Interval{ std::getenv("CS3910_REPORT_INTERVAL") })
+        options.interval = std::chrono::milliseconds{
+            std::strtoll(Interval, nullptr, 10) };
+    return options;
+}
+
+template<typename V>
+Reporter<V>::Reporter(
+    std::size_t size,
+    Label label,
+    ReportOptions const& options)
+    : size_{size}
+    , label_{std::move(label)}
+    , options_{options}
+    , solutions_{}
+    , free_{options.capacity}
+    , full_{options.capacity}
+    , start_{std::chrono::steady_clock::now()}
+    , dropped_{0}
+    , stop_{false}
+    , writer_{}
+{
+    // Both queues are rounded up alike, so every slot always fits in either
+    options_.capacity = free_.Capacity();
+    solutions_ = std::make_unique<value_type[]>(options_.capacity * size_);
+    for (std::size_t i{}; i < options_.capacity; ++i)
+        free_.TryPush(i);
+
+    if (options_.format == ReportFormat::Off)
+        return;
+    if (options_.format == ReportFormat::Csv)
+        std::cout << "seconds,iteration,source,value,solution\n";
+    writer_ = std::thread{[this](){ Write(); }};
+}
+
+template<typename V>
+Reporter<V>::~Reporter()
+{
+    Close();
+}
+
+template<typename V>
+template<typename InputIt>
+bool Reporter<V>::Publish(
+    std::size_t iteration,
+    double value,
+    InputIt first,
+    std::size_t source)
+    noexcept
+{
+    if (options_.format == ReportFormat::Off)
+        return true;
+
+    std::size_t slot;
+    if (!free_.TryPop(slot))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::copy_n(first, size_, solutions_.get() + slot * size_);
+    full_.TryPush(Event{
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(),
+        iteration,
+        value,
+        source,
+        slot});
+    return true;
+}
+
+template<typename V>
+void Reporter<V>::Close()
+{
+    if (!writer_.joinable())
+        return;
+
+    stop_.store(true, std::memory_order_release);
+    writer_.join();
+    if (auto const Dropped{ this->Dropped() }; Dropped != 0)
+        std::cerr << Dropped << " improvements were not reported\n";
+}
+
+template<typename V>
+std::size_t Reporter<V>::Dropped() const noexcept
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+template<typename V>
+void Reporter<V>::Write()
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr std::chrono::milliseconds Poll{ 1 };
+
+    std::ostringstream line{};
+    if (options_.format != ReportFormat::Text)
+        line.precision(std::numeric_limits<double>::max_digits10);
+
+    auto last{ Clock::now() - options_.interval };
+    bool pending{ false };
+    Event latest{};
+    auto const WriteLatest{ [&]()
+    {
+        line.str({});
+        Format(line, latest);
+        std::cout << line.str();
+        free_.TryPush(latest.slot);
+        pending = false;
+        last = Clock::now();
+    } };
+
+    for (;;)
+    {
+        // Read the flag first so nothing published before Close is missed
+        auto const Stopping{ stop_.load(std::memory_order_acquire) };
+
+        // A newer improvement replaces one still held back by the interval
+        Event event;
+        while (full_.TryPop(event))
+        {
+            if (pending)
+                free_.TryPush(latest.slot);
+            latest = event;
+            pending = true;
+            if (options_.interval <= Clock::now() - last)
+                WriteLatest();
+        }
+
+        if (pending && (Stopping || options_.interval <= Clock::now() - last))
+            WriteLatest();
+
+        std::cout.flush();
+        if (Stopping)
+            return;
+        std::this_thread::sleep_for(Poll);
+    }
+}
+
+template<typename V>
+void Reporter<V>::Format(std::ostream& outs, Event const& event) const
+{
+    switch (options_.format)
+    {
+    case ReportFormat::Text:
+        outs << event.iteration << ": " << event.value << ' ';
+        FormatSolution(outs, event, false);
+        break;
+    case ReportFormat::Csv:
+        outs << event.seconds << ',' << event.iteration << ','
+            << event.source << ',' << event.value << ',';
+        FormatSolution(outs, event, false);
+        break;
+    case ReportFormat::JsonLines:
+        outs << "{\"seconds\":" << event.seconds
+            << ",\"iteration\":" << event.iteration
+            << ",\"source\":" << event.source
+            << ",\"value\":" << event.value
+            << ",\"solution\":";
+        FormatSolution(outs, event, true);
+        outs << '}';
+        break;
+    case ReportFormat::Off:
+        return;
+    }
+    outs << '\n';
+}
+
+template<typename V>
+void Reporter<V>::FormatSolution(
+    std::ostream& outs,
+    Event const& event,
+    bool json) const
+{
+    auto const Solution{ solutions_.get() + event.slot * size_ };
+    auto const Separator{ json ? ',' : ' ' };
+    if (options_.format != ReportFormat::Csv)
+        outs << '[';
+    for (std::size_t i{}; i < size_; ++i)
+    {
+        if (i != 0)
+            outs << Separator;
+        if (!label_)
+            outs << Solution[i];
+        else if (!json)
+            outs << label_(Solution[i]);
+        else
+        {
+            outs << '"';
+            for (auto const c : label_(Solution[i]))
+            {
+                if (c == '"' || c == '\\')
+                    outs << '\\';
+                outs << c;
+            }
+            outs << '"';
+        }
+    }
+    if (options_.format != ReportFormat::Csv)
+        outs << ']';
+}
+
+#endif // !CS3910__REPORT_H_
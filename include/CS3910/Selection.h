@@ -0,0 +1,179 @@
+#ifndef CS3910__SELECTION_H_
+#define CS3910__SELECTION_H_
+
+#include "Random.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Kernels for roulette wheel selection over a contiguous array of weights.
+// The AVX2 paths are used when the translation unit is compiled with AVX2
+// enabled, see CS3910_ENABLE_AVX2.
+
+inline double SumWeights(double const* weights, std::size_t count) noexcept
+{
+    std::size_t i{};
+    double total{};
+#ifdef __AVX2__
+    auto sumA{ _mm256_setzero_pd() };
+    auto sumB{ _mm256_setzero_pd() };
+    for (; i + 8 <= count; i += 8)
+    {
+        sumA = _mm256_add_pd(sumA, _mm256_loadu_pd(weights + i));
+        sumB = _mm256_add_pd(sumB, _mm256_loadu_pd(weights + i + 4));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(sumA, sumB));
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; ++i)
+        total += weights[i];
+    return total;
+}
+
+// The index of the first weight at which the running sum exceeds target. When
+// rounding leaves target out of reach the last non-zero weight is chosen, or
+// zero if every weight is zero.
+inline std::size_t SelectWeight(
+    double const* weights,
+    std::size_t count,
+    double target) noexcept
+{
+    std::size_t i{};
+    double running{};
+#ifdef __AVX2__
+    auto const Zero{ _mm256_setzero_pd() };
+    auto const Target{ _mm256_set1_pd(target) };
+    auto runningLanes{ Zero };
+    for (; i + 4 <= count; i += 4)
+    {
+        // In-register inclusive prefix sum of four lanes
+        auto x{ _mm256_loadu_pd(weights + i) };
+        x = _mm256_add_pd(x, _mm256_blend_pd(
+            _mm256_permute4x64_pd(x, _MM_SHUFFLE(2, 1, 0, 0)),
+            Zero,
+            0b0001));
+        x = _mm256_add_pd(x, _mm256_blend_pd(
+            _mm256_permute4x64_pd(x, _MM_SHUFFLE(1, 0, 0, 0)),
+            Zero,
+            0b0011));
+        x = _mm256_add_pd(x, runningLanes);
+
+        auto const Mask{ _mm256_movemask_pd(_mm256_cmp_pd(x, Target, _CMP_GT_OQ)) };
+        if (Mask != 0)
+            for (std::size_t lane{};; ++lane)
+                if (Mask >> lane & 1)
+                    return i + lane;
+        runningLanes = _mm256_permute4x64_pd(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    running = _mm256_cvtsd_f64(runningLanes);
+#endif
+    for (; i < count; ++i)
+        if (target < (running += weights[i]))
+            return i;
+
+    while (count != 0 && !(0.0 < weights[count - 1]))
+        --count;
+    return count == 0 ? 0 : count - 1;
+}
+
+// Draw an index with probability proportional to its weight.
+template<typename RngT>
+std::size_t RouletteIndex(double const* weights, std::size_t count, RngT& rng)
+{
+    assert(count != 0);
+    auto const Total{ SumWeights(weights, count) };
+    return SelectWeight(
+        weights,
+        count,
+        Total * UniformUnit(rng));
+}
+
+// Walker's alias method for many draws from one fixed distribution. Building
+// is O(n) and every draw is O(1).
+class AliasTable final
+{
+public:
+    AliasTable() = default;
+
+    AliasTable(double const* weights, std::size_t count);
+
+    // Rebuild for new weights, reusing the storage.
+    void Assign(double const* weights, std::size_t count);
+
+    template<typename RngT>
+    std::size_t operator()(RngT& rng) const;
+
+    std::size_t Count() const noexcept;
+private:
+    std::vector<double> probability_;
+
+    std::vector<std::size_t> alias_;
+
+    std::vector<std::size_t> small_;
+
+    std::vector<std::size_t> large_;
+};
+
+inline AliasTable::AliasTable(double const* weights, std::size_t count)
+{
+    Assign(weights, count);
+}
+
+inline void AliasTable::Assign(double const* weights, std::size_t count)
+{
+    assert(count != 0);
+    auto const Scale{ count / SumWeights(weights, count) };
+    probability_.resize(count);
+    alias_.resize(count);
+    small_.clear();
+    large_.clear();
+    for (std::size_t i{}; i < count; ++i)
+    {
+        probability_[i] = weights[i] * Scale;
+        alias_[i] = i;
+        (probability_[i] < 1.0 ? small_ : large_).push_back(i);
+    }
+
+    while (!small_.empty() && !large_.empty())
+    {
+        auto const Small{ small_.back() };
+        auto const Large{ large_.back() };
+        small_.pop_back();
+        alias_[Small] = Large;
+        probability_[Large] -= 1.0 - probability_[Small];
+        if (probability_[Large] < 1.0)
+        {
+            large_.pop_back();
+            small_.push_back(Large);
+        }
+    }
+
+    // Whatever is left over is only short of one through rounding
+    for (auto const i : small_)
+        probability_[i] = 1.0;
+    for (auto const i : large_)
+        probability_[i] = 1.0;
+}
+
+template<typename RngT>
+std::size_t AliasTable::operator()(RngT& rng) const
+{
+    assert(!probability_.empty());
+    auto const Column{ UniformIndex(rng, probability_.size()) };
+    return UniformUnit(rng) < probability_[Column]
+        ? Column
+        : alias_[Column];
+}
+
+inline std::size_t AliasTable::Count() const noexcept
+{
+    return probability_.size();
+}
+
+#endif // !CS3910__SELECTION_H_
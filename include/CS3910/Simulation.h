@@ -1,10 +1,17 @@
 #ifndef CS3910__SIMULATION_H_
 #define CS3910__SIMULATION_H_
 
+#include "CS3910/Executor.h"
+
+// The executor lives for the whole simulation and is handed to the policy
+// when it is initialised.
 template<typename SimulationPolicy>
-void Simulate(SimulationPolicy&& policy)
+void Simulate(
+    SimulationPolicy&& policy,
+    ExecutorOptions const& options = ExecutorOptions::FromEnvironment())
 {
-    policy.Initialise();
+    Executor executor{ options };
+    policy.Initialise(executor);
     while(!policy.Terminate())
         policy.Step();
     policy.Complete();
@@ -0,0 +1,556 @@
+#ifndef CS3910__TOUR_H_
+#define CS3910__TOUR_H_
+
+#include "Neighbourhood.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A closed tour kept as a route and the position of every city in it, so
+// Next, Prev and Between are O(1) and a reversal is O(n) at worst. Tours
+// are walked through these queries alone, which lets local search run on
+// any representation offering them.
+template<typename I = std::size_t>
+class ArrayTour final
+{
+public:
+    using value_type = I;
+
+    explicit ArrayTour(std::size_t count);
+
+    // Take the order of the Count() cities starting at first.
+    template<typename InputIt>
+    void Assign(InputIt first);
+
+    // Write the cities in tour order starting from city.
+    template<typename OutputIt>
+    OutputIt Copy(OutputIt out, value_type city) const;
+
+    constexpr std::size_t Count() const noexcept;
+
+    value_type Next(value_type city) const noexcept;
+
+    value_type Prev(value_type city) const noexcept;
+
+    // True when b is met walking forward from a to c, both included.
+    bool Between(value_type a, value_type b, value_type c) const noexcept;
+
+    // Reverse the path running forward from a to b. The shorter side is
+    // reversed, so the tour may come out mirrored instead, which is the
+    // same closed route.
+    void Reverse(value_type a, value_type b) noexcept;
+private:
+    std::unique_ptr<value_type[]> cities_;
+
+    std::unique_ptr<value_type[]> positions_;
+
+    std::size_t count_;
+};
+
+// A closed tour kept as a ring of segments of about sqrt(n) cities, each a
+// doubly linked list with a reversal bit, after Fredman et al. Next, Prev
+// and Between are O(1). A reversal flips the cities of a path lying in one
+// segment in place, else moves the cities past its ends into the
+// neighbouring segments and then flips and relinks the whole segments
+// between, so it is O(sqrt(n)) where ArrayTour is O(n).
+template<typename I = std::size_t>
+class TwoLevelTour final
+{
+public:
+    using value_type = I;
+
+    explicit TwoLevelTour(std::size_t count);
+
+    // Take the order of the Count() cities starting at first.
+    template<typename InputIt>
+    void Assign(InputIt first);
+
+    // Write the cities in tour order starting from city.
+    template<typename OutputIt>
+    OutputIt Copy(OutputIt out, value_type city) const;
+
+    constexpr std::size_t Count() const noexcept;
+
+    value_type Next(value_type city) const noexcept;
+
+    value_type Prev(value_type city) const noexcept;
+
+    // True when b is met walking forward from a to c, both included.
+    bool Between(value_type a, value_type b, value_type c) const noexcept;
+
+    // Reverse the path running forward from a to b. The side spanning fewer
+    // segments is reversed, so the tour may come out mirrored instead, which
+    // is the same closed route.
+    void Reverse(value_type a, value_type b);
+private:
+    // The cities of a segment are linked first to last through next_ and
+    // walked last to first in the tour when it is reversed. Their ranks are
+    // consecutive, rising from first to last, and the ranks of the segments
+    // rise around the ring from one of them.
+    struct Segment
+    {
+        value_type first;
+        value_type last;
+        std::size_t next;
+        std::size_t prev;
+        std::size_t rank;
+        bool reversed;
+    };
+
+    std::vector<Segment> segments_;
+
+    std::unique_ptr<value_type[]> next_;
+
+    std::unique_ptr<value_type[]> prev_;
+
+    std::unique_ptr<std::uint32_t[]> parent_;
+
+    std::unique_ptr<std::int64_t[]> rank_;
+
+    std::vector<value_type> scratch_;
+
+    std::size_t count_;
+
+    value_type Head(Segment const& segment) const noexcept;
+
+    value_type Tail(Segment const& segment) const noexcept;
+
+    // The cities of the segment of city up to city, in tour order.
+    std::size_t Before(value_type city) const noexcept;
+
+    // Reverse the path from a to b lying in one segment.
+    void ReverseInside(value_type a, value_type b);
+
+    // Make city the head of its segment or, when after is set, the tail.
+    void Split(value_type city, bool after) noexcept;
+
+    // Move the head of segment s to the tail of the segment before it.
+    void MoveHead(std::size_t s) noexcept;
+
+    // Move the tail of segment s to the head of the segment after it.
+    void MoveTail(std::size_t s) noexcept;
+};
+
+template<typename Tour>
+struct TourTag
+{
+    using type = Tour;
+};
+
+// Call f with a TourTag of the tour type that suits count cities, an
+// ArrayTour unless its O(n) reversals would outweigh the indirections of a
+// TwoLevelTour.
+template<typename I, typename F>
+void WithTour(std::size_t count, F&& f);
+
+namespace internal
+{
+    // Measured on uniform random problems under LinKernighan local search
+    constexpr std::size_t TWO_LEVEL_TOUR_COUNT{ 16384 };
+}
+
+template<typename I>
+ArrayTour<I>::ArrayTour(std::size_t count)
+    : cities_{std::make_unique<value_type[]>(count)}
+    , positions_{std::make_unique<value_type[]>(count)}
+    , count_{count}
+{
+}
+
+template<typename I>
+template<typename InputIt>
+void ArrayTour<I>::Assign(InputIt first)
+{
+    for (std::size_t i{}; i < count_; ++i, ++first)
+    {
+        cities_[i] = *first;
+        positions_[cities_[i]] = static_cast<value_type>(i);
+    }
+}
+
+template<typename I>
+template<typename OutputIt>
+OutputIt ArrayTour<I>::Copy(OutputIt out, value_type city) const
+{
+    auto const From{ static_cast<std::size_t>(positions_[city]) };
+    for (auto i{ From }; i < count_; ++i)
+        *out++ = cities_[i];
+    for (std::size_t i{}; i < From; ++i)
+        *out++ = cities_[i];
+    return out;
+}
+
+template<typename I>
+constexpr std::size_t ArrayTour<I>::Count() const noexcept
+{
+    return count_;
+}
+
+template<typename I>
+typename ArrayTour<I>::value_type ArrayTour<I>::Next(value_type city) const noexcept
+{
+    auto const Position{ static_cast<std::size_t>(positions_[city]) };
+    return cities_[Position + 1 == count_ ? 0 : Position + 1];
+}
+
+template<typename I>
+typename ArrayTour<I>::value_type ArrayTour<I>::Prev(value_type city) const noexcept
+{
+    auto const Position{ static_cast<std::size_t>(positions_[city]) };
+    return cities_[Position == 0 ? count_ - 1 : Position - 1];
+}
+
+template<typename I>
+bool ArrayTour<I>::Between(
+    value_type a,
+    value_type b,
+    value_type c)
+    const noexcept
+{
+    auto const A{ positions_[a] };
+    auto const B{ positions_[b] };
+    auto const C{ positions_[c] };
+    return A <= C
+        ? A <= B && B <= C
+        : A <= B || B <= C;
+}
+
+template<typename I>
+void ArrayTour<I>::Reverse(value_type a, value_type b) noexcept
+{
+    auto const From{ static_cast<std::size_t>(positions_[a]) };
+    auto const To{ static_cast<std::size_t>(positions_[b]) };
+    auto const Length{ (To + count_ - From) % count_ + 1 };
+    if (2 * Length <= count_)
+        internal::ReverseCyclic(cities_.get(), count_, From, Length, positions_.get());
+    else // Reversing the rest of the tour gives the same closed route
+        internal::ReverseCyclic(
+            cities_.get(),
+            count_,
+            To + 1,
+            count_ - Length,
+            positions_.get());
+}
+
+template<typename I>
+TwoLevelTour<I>::TwoLevelTour(std::size_t count)
+    : segments_{}
+    , next_{std::make_unique<value_type[]>(count)}
+    , prev_{std::make_unique<value_type[]>(count)}
+    , parent_{std::make_unique<std::uint32_t[]>(count)}
+    , rank_{std::make_unique<std::int64_t[]>(count)}
+    , scratch_{}
+    , count_{count}
+{
+}
+
+template<typename I>
+template<typename InputIt>
+void TwoLevelTour<I>::Assign(InputIt first)
+{
+    // At least three segments, so a path and the rest of the tour never
+    // both span all of them
+    auto const Size{ std::max<std::size_t>(
+        1,
+        std::min(
+            static_cast<std::size_t>(std::sqrt(static_cast<double>(count_))),
+            count_ / 3)) };
+    auto const Segments{ (count_ + Size - 1) / Size };
+    segments_.assign(Segments, Segment{});
+    auto previous{ static_cast<value_type>(*first) };
+    for (std::size_t i{}; i < count_; ++i, ++first)
+    {
+        auto const City{ static_cast<value_type>(*first) };
+        auto const S{ i / Size };
+        auto& segment{ segments_[S] };
+        if (i % Size == 0)
+            segment = {City, City, (S + 1) % Segments, (S + Segments - 1) % Segments, S, false};
+        else
+        {
+            next_[previous] = City;
+            prev_[City] = previous;
+            segment.last = City;
+        }
+        parent_[City] = static_cast<std::uint32_t>(S);
+        rank_[City] = static_cast<std::int64_t>(i % Size);
+        previous = City;
+    }
+}
+
+template<typename I>
+template<typename OutputIt>
+OutputIt TwoLevelTour<I>::Copy(OutputIt out, value_type city) const
+{
+    for (std::size_t i{}; i < count_; ++i, city = Next(city))
+        *out++ = city;
+    return out;
+}
+
+template<typename I>
+constexpr std::size_t TwoLevelTour<I>::Count() const noexcept
+{
+    return count_;
+}
+
+template<typename I>
+typename TwoLevelTour<I>::value_type TwoLevelTour<I>::Next(value_type city) const noexcept
+{
+    auto const& segment{ segments_[parent_[city]] };
+    if (city == Tail(segment))
+        return Head(segments_[segment.next]);
+    return segment.reversed ? prev_[city] : next_[city];
+}
+
+template<typename I>
+typename TwoLevelTour<I>::value_type TwoLevelTour<I>::Prev(value_type city) const noexcept
+{
+    auto const& segment{ segments_[parent_[city]] };
+    if (city == Head(segment))
+        return Tail(segments_[segment.prev]);
+    return segment.reversed ? next_[city] : prev_[city];
+}
+
+template<typename I>
+bool TwoLevelTour<I>::Between(
+    value_type a,
+    value_type b,
+    value_type c)
+    const noexcept
+{
+    // Positions compare by segment rank, then by rank within the segment
+    auto const Less = [this](value_type x, value_type y)
+    {
+        auto const& X{ segments_[parent_[x]] };
+        auto const& Y{ segments_[parent_[y]] };
+        if (X.rank != Y.rank)
+            return X.rank < Y.rank;
+        return X.reversed ? rank_[y] < rank_[x] : rank_[x] < rank_[y];
+    };
+    return !Less(c, a)
+        ? !Less(b, a) && !Less(c, b)
+        : !Less(b, a) || !Less(c, b);
+}
+
+template<typename I>
+void TwoLevelTour<I>::Reverse(value_type a, value_type b)
+{
+    auto const Segments{ segments_.size() };
+    if (a == b || count_ < 3)
+        return;
+    if (parent_[a] == parent_[b])
+    {
+        if (Before(a) <= Before(b))
+            ReverseInside(a, b);
+        else if (auto const From{ Next(b) }; From != a)
+            ReverseInside(From, Prev(a)); // The rest of the tour, in the segment
+        return;
+    }
+
+    // Reverse whichever side crosses fewer segments
+    auto const& A{ segments_[parent_[a]] };
+    auto const& B{ segments_[parent_[b]] };
+    auto const Span{ (B.rank + Segments - A.rank) % Segments + 1 };
+    auto const Rest{ Segments - Span
+        + (b != Tail(B) ? 1 : 0)
+        + (a != Head(A) ? 1 : 0) };
+    if (Rest < Span)
+    {
+        if (auto const From{ Next(b) }; From != a)
+            Reverse(From, Prev(a));
+        return;
+    }
+
+    Split(a, false);
+    if (parent_[a] != parent_[b])
+        Split(b, true);
+    if (parent_[a] == parent_[b])
+    {
+        ReverseInside(a, b);
+        return;
+    }
+
+    // Flip every segment from a to b and link them in the opposite order,
+    // handing their ranks back in the order they held them
+    auto const First{ static_cast<std::size_t>(parent_[a]) };
+    auto const Last{ static_cast<std::size_t>(parent_[b]) };
+    auto const Outer{ segments_[First].prev };
+    auto const Inner{ segments_[Last].next };
+    auto rank{ segments_[First].rank };
+    for (auto s{ First }; ; )
+    {
+        auto& segment{ segments_[s] };
+        auto const Next{ segment.next };
+        segment.reversed = !segment.reversed;
+        std::swap(segment.next, segment.prev);
+        if (s == Last)
+            break;
+        s = Next;
+    }
+    for (auto s{ Last }; ; s = segments_[s].next)
+    {
+        segments_[s].rank = rank;
+        rank = rank + 1 == Segments ? 0 : rank + 1;
+        if (s == First)
+            break;
+    }
+    segments_[Outer].next = Last;
+    segments_[Last].prev = Outer;
+    segments_[First].next = Inner;
+    segments_[Inner].prev = First;
+}
+
+template<typename I>
+typename TwoLevelTour<I>::value_type
+TwoLevelTour<I>::Head(Segment const& segment) const noexcept
+{
+    return segment.reversed ? segment.last : segment.first;
+}
+
+template<typename I>
+typename TwoLevelTour<I>::value_type
+TwoLevelTour<I>::Tail(Segment const& segment) const noexcept
+{
+    return segment.reversed ? segment.first : segment.last;
+}
+
+template<typename I>
+std::size_t TwoLevelTour<I>::Before(value_type city) const noexcept
+{
+    auto const& segment{ segments_[parent_[city]] };
+    return static_cast<std::size_t>(segment.reversed
+        ? rank_[segment.last] - rank_[city]
+        : rank_[city] - rank_[segment.first]);
+}
+
+template<typename I>
+void TwoLevelTour<I>::ReverseInside(value_type a, value_type b)
+{
+    auto& segment{ segments_[parent_[a]] };
+    if (segment.reversed)
+        std::swap(a, b);
+
+    // Relink the cities from a to b in the order of the list the other way
+    scratch_.clear();
+    for (auto city{ a }; ; city = next_[city])
+    {
+        scratch_.push_back(city);
+        if (city == b)
+            break;
+    }
+    auto const Outer{ prev_[a] };
+    auto const Inner{ next_[b] };
+    auto rank{ rank_[a] };
+    for (auto it{ scratch_.rbegin() }; it + 1 != scratch_.rend(); ++it)
+    {
+        next_[it[0]] = it[1];
+        prev_[it[1]] = it[0];
+    }
+    for (auto it{ scratch_.rbegin() }; it != scratch_.rend(); ++it)
+        rank_[*it] = rank++;
+
+    if (a == segment.first)
+        segment.first = b;
+    else
+    {
+        next_[Outer] = b;
+        prev_[b] = Outer;
+    }
+    if (b == segment.last)
+        segment.last = a;
+    else
+    {
+        next_[a] = Inner;
+        prev_[Inner] = a;
+    }
+}
+
+template<typename I>
+void TwoLevelTour<I>::Split(value_type city, bool after) noexcept
+{
+    // Move the shorter side of the cut into the neighbouring segment
+    auto const S{ static_cast<std::size_t>(parent_[city]) };
+    auto const Size{ static_cast<std::size_t>(
+        rank_[segments_[S].last] - rank_[segments_[S].first] + 1) };
+    auto const Leading{ Before(city) + (after ? 1 : 0) };
+    if (Leading == 0 || Leading == Size)
+        return;
+    if (Leading <= Size - Leading)
+        for (std::size_t i{}; i < Leading; ++i)
+            MoveHead(S);
+    else
+        for (auto i{ Leading }; i < Size; ++i)
+            MoveTail(S);
+}
+
+template<typename I>
+void TwoLevelTour<I>::MoveHead(std::size_t s) noexcept
+{
+    auto& from{ segments_[s] };
+    auto& to{ segments_[from.prev] };
+    auto const City{ Head(from) };
+    if (from.reversed)
+        from.last = prev_[City];
+    else
+        from.first = next_[City];
+
+    auto const End{ Tail(to) };
+    if (to.reversed)
+    {
+        prev_[End] = City;
+        next_[City] = End;
+        rank_[City] = rank_[End] - 1;
+        to.first = City;
+    }
+    else
+    {
+        next_[End] = City;
+        prev_[City] = End;
+        rank_[City] = rank_[End] + 1;
+        to.last = City;
+    }
+    parent_[City] = static_cast<std::uint32_t>(from.prev);
+}
+
+template<typename I>
+void TwoLevelTour<I>::MoveTail(std::size_t s) noexcept
+{
+    auto& from{ segments_[s] };
+    auto& to{ segments_[from.next] };
+    auto const City{ Tail(from) };
+    if (from.reversed)
+        from.first = next_[City];
+    else
+        from.last = prev_[City];
+
+    auto const End{ Head(to) };
+    if (to.reversed)
+    {
+        next_[End] = City;
+        prev_[City] = End;
+        rank_[City] = rank_[End] + 1;
+        to.last = City;
+    }
+    else
+    {
+        prev_[End] = City;
+        next_[City] = End;
+        rank_[City] = rank_[End] - 1;
+        to.first = City;
+    }
+    parent_[City] = static_cast<std::uint32_t>(from.next);
+}
+
+template<typename I, typename F>
+void WithTour(std::size_t count, F&& f)
+{
+    if (count < internal::TWO_LEVEL_TOUR_COUNT)
+        f(TourTag<ArrayTour<I>>{});
+    else
+        f(TourTag<TwoLevelTour<I>>{});
+}
+
+#endif // !CS3910__TOUR_H_
@@ -1,13 +1,37 @@
 #define _USE_MATH_DEFINES
 
 #include "CS3910/AntennaArray.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <limits>
 
 const double AntennaArray::MIN_SPACING = 0.25;
 
-AntennaArray::AntennaArray(unsigned int n_ant, double steering_ang)
-  : n_antennae(n_ant), steering_angle(steering_ang)
-{}
+AntennaArray::AntennaArray(unsigned int n_ant, double steering_ang, double tolerance)
+  : n_antennae(n_ant), steering_angle(steering_ang), tolerance(tolerance)
+{
+  elevations.push_back(0.0);
+  if (tolerance > 0) {
+    //Lobes are at least 180 / (pi * n_antennae) degrees wide, so a quarter of
+    //that brackets every peak.
+    const double step = std::min(0.5, 45 / (M_PI * n_antennae));
+    for (std::size_t i = 1; i * step < 180.0; ++i)
+      elevations.push_back(i * step);
+  }
+  else {
+    //Sample the elevations exactly as the original sweep did, accumulating
+    //the step, and finish with 180 itself.
+    for (double elevation = 0.01; elevation <= 180.0; elevation += 0.01)
+      elevations.push_back(elevation);
+  }
+  elevations.push_back(180.0);
+
+  const double steering = cos(2 * M_PI * steering_angle / 360);
+  phases.reserve(elevations.size());
+  for (double elevation : elevations)
+    phases.push_back(2 * M_PI * (cos(2 * M_PI * elevation / 360) - steering));
+}
 
 std::size_t AntennaArray::count() const noexcept
 {
@@ -23,3 +47,40 @@ std::vector<Bounds> AntennaArray::bounds() const
 }
 
 
+void AntennaArray::evaluate_batch(
+    const double* designs,
+    std::size_t stride,
+    std::size_t count,
+    double* out)
+{
+  assert(n_antennae <= stride);
+  //A group of designs shares each block of phases while it is in cache.
+  constexpr std::size_t group_size = 8;
+  double power[block_size];
+  std::size_t members[group_size];
+  std::array<Scan, group_size> states;
+  for (std::size_t group = 0; group < count; group += group_size) {
+    std::size_t valid = 0;
+    for (std::size_t i = group; i < std::min(count, group + group_size); ++i) {
+      const double* first = designs + i * stride;
+      if (is_valid(first, first + n_antennae)) {
+        states[valid] = Scan(steering_angle);
+        members[valid++] = i;
+      }
+      else
+        out[i] = std::numeric_limits<double>::max();
+    }
+
+    for (std::size_t from = 0; from < elevations.size(); from += block_size) {
+      const std::size_t samples = std::min(block_size, elevations.size() - from);
+      for (std::size_t j = 0; j < valid; ++j) {
+        const double* first = designs + members[j] * stride;
+        array_factors(first, first + n_antennae, from, samples, power);
+        scan(first, first + n_antennae, from, samples, power, states[j]);
+      }
+    }
+
+    for (std::size_t j = 0; j < valid; ++j)
+      out[members[j]] = states[j].summary.side_lobe_level();
+  }
+}
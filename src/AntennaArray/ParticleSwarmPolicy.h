@@ -0,0 +1,287 @@
+#ifndef PARTICLESWARMPOLICY_H_
+#define PARTICLESWARMPOLICY_H_
+
+#include "CS3910/AntennaArray.h"
+#include "CS3910/Memory.h"
+#include "CS3910/Random.h"
+#include "CS3910/Report.h"
+#include "CS3910/Simulation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+class CS3910ParticleSwarmPolicy
+{
+public:
+    struct Parameters
+    {
+        std::size_t populationSize;
+        std::size_t iterations;
+        double n;
+        double o1;
+        double o2;
+        std::uint64_t seed; // Of every generator, random when zero
+    };
+
+    explicit CS3910ParticleSwarmPolicy(
+        AntennaArray& env,
+        Parameters const& params) noexcept;
+
+    void Initialise(Executor& executor);
+
+    void Step();
+
+    void Complete()
+    {
+        reporter_->Close();
+    }
+
+    // The lowest peak SLL found so far.
+    double Best() const noexcept;
+
+    // The number of designs evaluated so far.
+    std::size_t Evaluations() const noexcept;
+
+    bool Terminate();
+private:
+    using Block = AlignedArray<double>;
+
+    AntennaArray& env_;
+
+    // The swarm is stored as blocks with one row of stride_ values per
+    // particle. The padding and the fixed last antenna are never moved.
+    std::size_t stride_;
+
+    Block positions_;
+
+    Block velocities_;
+
+    Block bestPositions_;
+
+    // Two rows of random coefficients per particle, for the global and then
+    // the personal best.
+    Block coefficients_;
+
+    Block sll_;
+
+    Block bestSLLs_;
+
+    std::unique_ptr<Philox4x32[]> rngs_;
+
+    Executor* executor_;
+
+    std::unique_ptr<Reporter<double>> reporter_;
+
+    double bestSLL_;
+
+    Block bestPosition_;
+
+    std::size_t iteration_;
+
+    std::size_t evaluations_;
+
+    Parameters params_;
+
+    double* Row(Block& block, std::size_t particle) noexcept
+    {
+        return block.Data() + particle * stride_;
+    }
+
+    void Update(std::size_t particle);
+
+    void Evaluate();
+
+    void UpdateBest()
+    {
+        auto it = std::min_element(
+            sll_.Data(),
+            sll_.Data() + params_.populationSize);
+
+        if (it != sll_.Data() + params_.populationSize && *it < bestSLL_)
+        {
+            bestSLL_ = *it;
+            std::copy_n(
+                Row(positions_, it - sll_.Data()),
+                stride_,
+                bestPosition_.Data());
+
+            reporter_->Publish(iteration_, bestSLL_, bestPosition_.Data());
+        }
+    }
+
+    template<typename RandomIt>
+    void Fix(RandomIt first, RandomIt last)
+    {
+        assert(first != last);
+        std::sort(first, last - 1);
+
+        if(auto min = env_.bounds().back().min; *first < min)
+            *first = min;
+
+        for(auto i = first + 1; i != last - 1; ++i)
+        {
+            if(i[0] < i[-1] + AntennaArray::MIN_SPACING)
+                i[0] = i[-1] + AntennaArray::MIN_SPACING;
+        }
+
+        for(auto i = last - 2; i != first - 1; --i)
+        {
+            if(i[0] > i[1] - AntennaArray::MIN_SPACING)
+                i[0] = i[1] - AntennaArray::MIN_SPACING;
+        }
+    }
+
+    template<typename RandomIt, typename RngT>
+    void Place(RandomIt first, RandomIt last, RngT& rng);
+};
+
+inline CS3910ParticleSwarmPolicy::CS3910ParticleSwarmPolicy(
+    AntennaArray& env,
+    Parameters const& params)
+    noexcept
+    : env_{env}
+    , params_{params}
+{
+}
+
+inline void CS3910ParticleSwarmPolicy::Initialise(Executor& executor)
+{
+    executor_ = &executor;
+    reporter_ = std::make_unique<Reporter<double>>(env_.count());
+    iteration_ = 0;
+    evaluations_ = 0;
+    bestSLL_ = std::numeric_limits<double>::infinity();
+    stride_ = AlignedStride<double>(env_.count());
+
+    auto const Size{ params_.populationSize * stride_ };
+    positions_ = Block(Size);
+    velocities_ = Block(Size);
+    bestPositions_ = Block(Size);
+    coefficients_ = Block(2 * Size);
+    sll_ = Block(params_.populationSize);
+    bestSLLs_ = Block(params_.populationSize);
+    bestPosition_ = Block(stride_);
+    rngs_ = std::make_unique<Philox4x32[]>(params_.populationSize);
+
+    auto const Seed{ MasterSeed(params_.seed) };
+    for (std::size_t i{}; i < params_.populationSize; ++i)
+    {
+        rngs_[i].seed(Seed, i);
+        Place(Row(positions_, i), Row(positions_, i) + env_.count(), rngs_[i]);
+    }
+    std::copy_n(positions_.Data(), Size, bestPositions_.Data());
+
+    Evaluate();
+    std::copy_n(sll_.Data(), params_.populationSize, bestSLLs_.Data());
+}
+
+inline void CS3910ParticleSwarmPolicy::Step()
+{
+    UpdateBest();
+    executor_->ParallelFor(
+        0,
+        params_.populationSize,
+        [&](auto i){ Update(i); });
+
+    Evaluate();
+    for (std::size_t i{}; i < params_.populationSize; ++i)
+    {
+        if(sll_[i] < bestSLLs_[i])
+        {
+            bestSLLs_[i] = sll_[i];
+            std::copy_n(Row(positions_, i), stride_, Row(bestPositions_, i));
+        }
+    }
+}
+
+inline void CS3910ParticleSwarmPolicy::Evaluate()
+{
+    evaluations_ += params_.populationSize;
+
+    // Hand each thread a group of particles to evaluate together
+    constexpr std::size_t GroupSize{ 8 };
+    auto const Groups{ (params_.populationSize + GroupSize - 1) / GroupSize };
+    executor_->ParallelFor(
+        0,
+        Groups,
+        [&](auto group)
+    {
+        auto const First{ group * GroupSize };
+        env_.evaluate_batch(
+            Row(positions_, First),
+            stride_,
+            std::min(GroupSize, params_.populationSize - First),
+            sll_.Data() + First);
+    });
+}
+
+inline void CS3910ParticleSwarmPolicy::Update(std::size_t particle)
+{
+    auto* const Global{ Row(coefficients_, 2 * particle) };
+    auto* const Personal{ Global + stride_ };
+    auto& rng{ rngs_[particle] };
+    for (std::size_t i{}; i < env_.count() - 1; ++i)
+    {
+        Global[i] = params_.o1 * UniformUnit(rng);
+        Personal[i] = params_.o2 * UniformUnit(rng);
+    }
+
+    // The coefficients of the last antenna and of the padding stay zero, so
+    // the whole row can be moved at once.
+    auto* const Position{ Row(positions_, particle) };
+    auto* const Velocity{ Row(velocities_, particle) };
+    auto const* const PersonalBest{ Row(bestPositions_, particle) };
+    auto const* const GlobalBest{ bestPosition_.Data() };
+    for (std::size_t i{}; i < stride_; ++i)
+    {
+        Velocity[i] = params_.n * Velocity[i]
+            + Global[i] * (GlobalBest[i] - Position[i])
+            + Personal[i] * (PersonalBest[i] - Position[i]);
+        Position[i] += Velocity[i];
+    }
+
+    Fix(Position, Position + env_.count());
+}
+
+template<typename RandomIt, typename RngT>
+void CS3910ParticleSwarmPolicy::Place(RandomIt first, RandomIt last, RngT& rng)
+{
+    assert(first != last);
+    assert(std::distance(first, last) == env_.count());
+
+    auto const [Min, Max] = env_.bounds().back();
+    *(--last) = Max;
+
+    do
+    {
+        std::for_each(first, last, [&](auto& x)
+        {
+            x = Min + (Max - Min) * UniformUnit(rng);
+        });
+
+        Fix(first, last + 1);
+    }
+    while (!env_.is_valid(first, last + 1));
+}
+
+inline bool CS3910ParticleSwarmPolicy::Terminate()
+{
+    return params_.iterations < iteration_++;
+}
+
+inline double CS3910ParticleSwarmPolicy::Best() const noexcept
+{
+    return bestSLL_;
+}
+
+inline std::size_t CS3910ParticleSwarmPolicy::Evaluations() const noexcept
+{
+    return evaluations_;
+}
+
+#endif // !PARTICLESWARMPOLICY_H_
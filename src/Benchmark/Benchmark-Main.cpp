@@ -0,0 +1,379 @@
+#include "AntSystemPolicy.h"
+#include "EvolutionPolicy.h"
+#include "HillClimbPolicy.h"
+#include "LocalSearchPolicy.h"
+#include "ParticleSwarmPolicy.h"
+#include "RandomSearchPolicy.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Runs the policies on generated problems with fixed seeds and writes one
+// JSON object per run to stdout. Every run is forked, so the peak RSS
+// reported is its own.
+
+struct BenchmarkOptions
+{
+    std::vector<std::string> policies;
+    std::vector<std::size_t> cities;
+    std::vector<std::size_t> antennae;
+    std::vector<std::size_t> threads;
+    double seconds; // Per run, checked between steps
+    std::uint64_t seed;
+};
+
+struct Measurement
+{
+    double seconds;
+    std::size_t evaluations;
+    double best;
+    double target;
+    double timeToTarget; // Negative when the target was not reached
+};
+
+// Larger problems are given implicit distances, a matrix of 10k cities
+// takes 400MB.
+constexpr std::size_t MATRIX_LIMIT{ 2000 };
+
+// A hill climbing restart is a whole local search from a random route, which
+// takes minutes beyond this many cities whatever the budget.
+constexpr std::size_t HILL_LIMIT{ 1000 };
+
+// Run policy on threads until it terminates or the budget is spent.
+// Initialisation counts towards the time.
+template<typename Policy>
+Measurement Measure(
+    Policy& policy,
+    std::size_t threads,
+    double target,
+    double budget)
+{
+    using Clock = std::chrono::steady_clock;
+    Executor executor{ ExecutorOptions{threads, false} };
+    auto const Start{ Clock::now() };
+
+    Measurement measurement{0.0, 0, 0.0, target, -1.0};
+    policy.Initialise(executor);
+    while (!policy.Terminate() && measurement.seconds < budget)
+    {
+        policy.Step();
+        measurement.seconds =
+            std::chrono::duration<double>(Clock::now() - Start).count();
+        if (measurement.timeToTarget < 0.0 && policy.Best() <= target)
+            measurement.timeToTarget = measurement.seconds;
+    }
+    measurement.evaluations = policy.Evaluations();
+    measurement.best = policy.Best();
+    return measurement;
+}
+
+void Write(
+    std::string const& policy,
+    std::size_t size,
+    std::size_t threads,
+    BenchmarkOptions const& options,
+    Measurement const& measurement)
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::ostringstream line{};
+    line.precision(std::numeric_limits<double>::max_digits10);
+    line << "{\"policy\":\"" << policy << '"'
+        << ",\"size\":" << size
+        << ",\"threads\":" << threads
+        << ",\"seed\":" << options.seed
+        << ",\"seconds\":" << measurement.seconds
+        << ",\"evaluations\":" << measurement.evaluations
+        << ",\"evaluationsPerSecond\":"
+            << measurement.evaluations / measurement.seconds
+        << ",\"best\":" << measurement.best
+        << ",\"target\":" << measurement.target
+        << ",\"timeToTarget\":";
+    if (measurement.timeToTarget < 0.0)
+        line << "null";
+    else
+        line << measurement.timeToTarget;
+    line << ",\"peakRssKiB\":" << usage.ru_maxrss << "}\n";
+    std::cout << line.str() << std::flush;
+}
+
+// Cities spread uniformly over a 1000 by 1000 square.
+template<typename NodeInfo>
+std::vector<NodeInfo> GenerateCities(std::size_t count, std::uint64_t seed)
+{
+    std::mt19937_64 rng{ seed };
+    std::uniform_real_distribution<> d{0.0, 1000.0};
+    std::vector<NodeInfo> cities(count);
+    for (std::size_t i{}; i < count; ++i)
+    {
+        cities[i].name = std::to_string(i + 1);
+        cities[i].x = d(rng);
+        cities[i].y = d(rng);
+    }
+    return cities;
+}
+
+// The target is the length of the nearest neighbour route of the problem.
+void RunTravlingSalesman(
+    std::string const& policy,
+    std::size_t cities,
+    std::size_t threads,
+    BenchmarkOptions const& options)
+{
+    auto const Mode{ cities <= MATRIX_LIMIT
+        ? DistanceMode::Matrix
+        : DistanceMode::Implicit };
+    auto const Candidates{ policy == "ACO" ? 20 : policy == "Hill" || policy == "LS" ? 10 : 0 };
+    auto const Iterations{ std::numeric_limits<std::size_t>::max() / 2 };
+
+    WithDistanceMode<double>(Mode, [&](auto graph)
+    {
+        using Graph = typename decltype(graph)::type;
+        using Problem = TravlingSalesman<double, Graph>;
+        Problem problem{
+            GenerateCities<typename Problem::NodeInfo>(cities, options.seed),
+            static_cast<std::size_t>(Candidates),
+            Metric::Euclidean,
+            ExecutorOptions{threads, false} };
+
+        std::vector<std::size_t> route(cities);
+        std::iota(route.begin(), route.end(), std::size_t{});
+        NearestNeighbourRoute(problem.Env(), route.begin(), route.end());
+        auto const Target{ CostOf(problem.Env(), route.begin(), route.end()) };
+
+        WithRouteIndex(cities, [&](auto index)
+        {
+            using I = typename decltype(index)::type;
+            if (policy == "RNG")
+            {
+                using Policy = CS3910RandomSearchPolicy<double, Graph, I>;
+                typename Policy::Parameters params{};
+                params.iterations = Iterations;
+                params.seed = options.seed;
+                Policy x{std::move(problem), params};
+                Write(policy, cities, threads, options,
+                    Measure(x, threads, Target, options.seconds));
+            }
+            else if (policy == "Hill")
+            {
+                // Every restart is one complete local search, so there is
+                // one per thread rather than a time limit.
+                using Policy = CS3910HillClimbPolicy<double, Graph, I>;
+                typename Policy::Parameters params{};
+                params.iterations = threads;
+                params.move = NeighbourhoodMove::Swap;
+                params.strategy = ImprovementStrategy::Best;
+                params.workers = threads;
+                params.seed = options.seed;
+                Policy x{std::move(problem), params};
+                Write(policy, cities, threads, options,
+                    Measure(x, threads, Target, options.seconds));
+            }
+            else if (policy == "EA")
+            {
+                using Policy = CS3910EvolutionPolicy<double, Graph, I>;
+                typename Policy::Parameters params{};
+                params.k = 2;
+                params.populationSize = 100;
+                params.eliteSize = 99;
+                params.iterations = Iterations;
+                params.randomGenerationProbabillity = 5;
+                params.mutationProbabillity = 70;
+                params.mutation = NeighbourhoodMove::Swap;
+                params.crossover = CrossoverOperator::Order1;
+                params.islands = threads;
+                params.epochLength = 10;
+                params.migrants = 2;
+                params.topology = MigrationTopology::Ring;
+                params.seed = options.seed;
+                Policy x{std::move(problem), params};
+                Write(policy, cities, threads, options,
+                    Measure(x, threads, Target, options.seconds));
+            }
+            else if (policy == "LS")
+            {
+                WithTour<I>(cities, [&](auto tour)
+                {
+                    using Policy = CS3910LocalSearchPolicy<
+                        double,
+                        Graph,
+                        I,
+                        typename decltype(tour)::type>;
+                    typename Policy::Parameters params{};
+                    params.iterations = Iterations;
+                    params.move = LocalSearchMove::LinKernighan;
+                    params.workers = threads;
+                    params.seed = options.seed;
+                    Policy x{std::move(problem), params};
+                    Write(policy, cities, threads, options,
+                        Measure(x, threads, Target, options.seconds));
+                });
+            }
+            else if (policy == "ACO")
+            {
+                using Policy = CS3910AntSystemPolicy<double, Graph, I>;
+                typename Policy::Parameters params{};
+                params.populationSize = 100;
+                params.iterations = Iterations;
+                params.t0 = 0.001;
+                params.p = 0.5;
+                params.q = 100.0;
+                params.a = 1.0;
+                params.b = 5.0;
+                params.seed = options.seed;
+                Policy x{std::move(problem), params};
+                Write(policy, cities, threads, options,
+                    Measure(x, threads, Target, options.seconds));
+            }
+        });
+    });
+}
+
+// The target is the peak SLL of the evenly spaced design.
+void RunAntennaArray(
+    std::size_t antennae,
+    std::size_t threads,
+    BenchmarkOptions const& options)
+{
+    AntennaArray array{ static_cast<unsigned>(antennae), 90.0, 0.01 };
+    std::vector<double> design(antennae);
+    for (std::size_t i{}; i < antennae; ++i)
+        design[i] = i * (antennae / 2.0) / (antennae - 1);
+    auto const Target{ array.evaluate(design.begin(), design.end()) };
+
+    CS3910ParticleSwarmPolicy::Parameters params{};
+    params.populationSize = 20 + std::sqrt(array.count());
+    params.iterations = std::numeric_limits<std::size_t>::max() / 2;
+    params.n = 1.0 / (2.0 * std::log(2));
+    params.o1 = 1.0 / 2.0 + std::log(2);
+    params.o2 = 1.0 / 2.0 + std::log(2);
+    params.seed = options.seed;
+    CS3910ParticleSwarmPolicy x{array, params};
+    Write("PSO", antennae, threads, options,
+        Measure(x, threads, Target, options.seconds));
+}
+
+template<typename T>
+std::vector<T> ParseList(char const* list)
+{
+    std::vector<T> values{};
+    std::istringstream ins{ list };
+    std::string item;
+    while (std::getline(ins, item, ','))
+    {
+        T value{};
+        std::istringstream{item} >> value;
+        values.push_back(value);
+    }
+    return values;
+}
+
+int main(int argc, char const** argv)
+{
+    std::vector<std::string> const Policies{"RNG", "Hill", "EA", "ACO", "LS", "PSO"};
+    BenchmarkOptions options{};
+    options.policies = Policies;
+    options.cities = {16, 100, 1000, 10000};
+    options.antennae = {3, 6, 10, 20};
+    options.seconds = 2.0;
+    options.seed = 1;
+    auto const Cores{ std::max(1u, std::thread::hardware_concurrency()) };
+    for (std::size_t threads{1}; threads < Cores; threads *= 2)
+        options.threads.push_back(threads);
+    options.threads.push_back(Cores);
+
+    for (int i{1}; i + 1 < argc; i += 2)
+    {
+        std::string const Name{ argv[i] };
+        if (Name == "--policies")
+            options.policies = ParseList<std::string>(argv[i + 1]);
+        else if (Name == "--cities")
+            options.cities = ParseList<std::size_t>(argv[i + 1]);
+        else if (Name == "--antennae")
+            options.antennae = ParseList<std::size_t>(argv[i + 1]);
+        else if (Name == "--threads")
+            options.threads = ParseList<std::size_t>(argv[i + 1]);
+        else if (Name == "--seconds")
+            std::istringstream{argv[i + 1]} >> options.seconds;
+        else if (Name == "--seed")
+            std::istringstream{argv[i + 1]} >> options.seed;
+        else
+        {
+            std::cerr << "Unknown option " << Name << '\n'
+                << "Options are --policies RNG,Hill,EA,ACO,LS,PSO, --cities, "
+                << "--antennae and --threads lists, --seconds and --seed\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (auto const& policy : options.policies)
+        if (std::find(Policies.begin(), Policies.end(), policy) == Policies.end())
+        {
+            std::cerr << "Unknown policy " << policy
+                << ", the policies are RNG, Hill, EA, ACO, LS and PSO\n";
+            return EXIT_FAILURE;
+        }
+    // The evenly spaced design of the target needs two antennae to span
+    if (std::any_of(
+        options.antennae.begin(),
+        options.antennae.end(),
+        [](auto antennae){ return antennae < 2; }))
+    {
+        std::cerr << "Every antenna array needs at least 2 antennae\n";
+        return EXIT_FAILURE;
+    }
+
+    // The improvements of the policies would be mixed into the results
+    setenv("CS3910_REPORT", "off", 1);
+
+    auto const Fork = [](auto&& run)
+    {
+        std::cout.flush();
+        auto const Child{ fork() };
+        if (Child < 0)
+        {
+            std::cerr << "A run could not be started\n";
+            return;
+        }
+        if (Child == 0)
+        {
+            run();
+            std::cout.flush();
+            std::_Exit(EXIT_SUCCESS);
+        }
+
+        int status{};
+        waitpid(Child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            std::cerr << "A run failed\n";
+    };
+
+    for (auto const& policy : options.policies)
+        for (auto const Threads : options.threads)
+        {
+            if (policy == "PSO")
+                for (auto const Antennae : options.antennae)
+                    Fork([&](){ RunAntennaArray(Antennae, Threads, options); });
+            else
+                for (auto const Cities : options.cities)
+                    if (policy == "Hill" && HILL_LIMIT < Cities)
+                        std::cerr << "Skipping Hill on " << Cities << " cities\n";
+                    else
+                        Fork([&](){ RunTravlingSalesman(policy, Cities, Threads, options); });
+        }
+}
@@ -0,0 +1,340 @@
+#ifndef ANTSYSTEMPOLICY_H_
+#define ANTSYSTEMPOLICY_H_
+
+#include "TravlingSalesman.h"
+#include "CS3910/Graph.h"
+#include "CS3910/Pheromone.h"
+#include "CS3910/Random.h"
+#include "CS3910/Report.h"
+#include "CS3910/Selection.h"
+#include "CS3910/Simulation.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+template<
+    typename T,
+    typename Graph = SymmetricMatrix<T>,
+    typename I = std::size_t>
+class CS3910AntSystemPolicy: private TravlingSalesman<T, Graph>
+{
+public:
+    using value_type = struct
+    {
+        CostType<Graph> cost;
+        std::unique_ptr<I[]> route;
+        Philox4x32 rng{};
+        std::unique_ptr<double[]> desire; // Selection weights
+        std::unique_ptr<I[]> positions; // Of each city in route
+    };
+
+    struct Parameters
+    {
+        std::size_t populationSize;
+        std::size_t iterations;
+        double t0; // Initial pheromone level
+        double p; // Rate of evaporation
+        double q; // Rate of deposition
+        double a; // Relative importance of phermonone
+        double b; // Relative importance of edge weight
+        bool polish; // Polish the best route once the search completes
+        std::uint64_t seed; // Of every generator, random when zero
+    };
+
+    explicit CS3910AntSystemPolicy(
+        TravlingSalesman<T, Graph>&& problem,
+        Parameters const& params);
+
+    void Initialise(Executor& executor);
+
+    void Step();
+
+    void Complete();
+
+    // The best cost found so far.
+    T Best() const noexcept;
+
+    // The number of routes costed so far.
+    std::size_t Evaluations() const noexcept;
+
+    bool Terminate() noexcept;
+private:
+
+    std::unique_ptr<value_type[]> population_;
+
+    PheromoneStore<T> pheromone_;
+
+    // Of every edge without candidate lists, else of the candidate edges in
+    // the layout of the candidate HeuristicInfo
+    SymmetricMatrix<T> heuristic_;
+
+    SymmetricMatrix<T> choice_;
+
+    std::vector<T> candidateHeuristic_;
+
+    std::vector<T> candidateChoice_;
+
+    std::size_t iteration_;
+
+    std::size_t evaluations_;
+
+    T best_;
+
+    std::unique_ptr<I[]> bestRoute_;
+
+    Executor* executor_;
+
+    std::unique_ptr<Reporter<I>> reporter_;
+
+    Parameters params_;
+
+    void UpdateChoice();
+
+    // The choice value of an edge that is not in the candidate tables.
+    T Choice(std::size_t x, std::size_t y) noexcept;
+
+    template<typename RandomIt, typename RngT>
+    void Construct(
+        RandomIt first,
+        RandomIt last,
+        RngT& rng,
+        double* desire,
+        I* positions);
+};
+
+template<typename T, typename Graph, typename I>
+CS3910AntSystemPolicy<T, Graph, I>::CS3910AntSystemPolicy(
+    TravlingSalesman<T, Graph>&& problem,
+    Parameters const& params)
+    : TravlingSalesman<T, Graph>{ std::move(problem) }
+    , pheromone_{this->Env().Count()}
+    , heuristic_{0}
+    , choice_{0}
+    , params_{params}
+{
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910AntSystemPolicy<T, Graph, I>::Initialise(Executor& executor)
+{
+    executor_ = &executor;
+    reporter_ = std::make_unique<Reporter<I>>(
+        this->Env().Count(),
+        [this](I const& x){ return std::string_view{ this->Node(x).name }; });
+    best_ = std::numeric_limits<T>::infinity();
+    bestRoute_ = std::make_unique<I[]>(this->Env().Count());
+    iteration_ = 0;
+    evaluations_ = 0;
+    population_ = std::make_unique<value_type[]>(params_.populationSize);
+    auto const Seed{ MasterSeed(params_.seed) };
+    std::for_each(
+        population_.get(),
+        population_.get() + params_.populationSize,
+        [&](auto& ant)
+        {
+            ant.cost = 0.0;
+            ant.route = std::make_unique<I[]>(this->Env().Count());
+            ant.rng.seed(Seed, &ant - population_.get());
+            ant.desire = std::make_unique<double[]>(this->Env().Count());
+            if (!this->Candidates().Empty())
+                ant.positions = std::make_unique<I[]>(this->Env().Count());
+            std::iota(
+                ant.route.get(),
+                ant.route.get() + this->Env().Count(),
+                0);
+        });
+
+    pheromone_.Reset(params_.t0);
+    if (this->Candidates().Empty())
+    {
+        heuristic_ = HeuristicInfo(this->Env(), params_.b);
+        choice_ = SymmetricMatrix<T>{this->Env().Count()};
+    }
+    else
+        candidateHeuristic_ = HeuristicInfo(this->Env(), this->Candidates(), params_.b);
+    UpdateChoice();
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910AntSystemPolicy<T, Graph, I>::Step()
+{
+    executor_->ParallelFor(0, params_.populationSize, [&](auto i)
+    {
+        auto& [cost, route, rng, desire, positions] = population_[i];
+        Construct(
+            route.get(),
+            route.get() + this->Env().Count(),
+            rng,
+            desire.get(),
+            positions.get());
+        cost = CostOf(
+            this->Env(),
+            route.get(),
+            route.get() + this->Env().Count());
+
+        // Deposits are not visible to the other ants until the update
+        pheromone_.Deposit(
+            params_.q / cost,
+            route.get(),
+            route.get() + this->Env().Count());
+    });
+
+    evaluations_ += params_.populationSize;
+
+    pheromone_.Update(params_.p, *executor_);
+    UpdateChoice();
+
+    auto it = std::min_element(
+        population_.get(),
+        population_.get() + params_.populationSize,
+        [=](auto& a, auto& b)
+        {
+            return a.cost < b.cost;
+        });
+
+    if(it != population_.get() + params_.populationSize && it->cost < best_)
+    {
+        best_ = it->cost;
+        std::copy_n(it->route.get(), this->Env().Count(), bestRoute_.get());
+        reporter_->Publish(iteration_, best_, it->route.get());
+    }
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910AntSystemPolicy<T, Graph, I>::Complete()
+{
+    auto const Count{ this->Env().Count() };
+    if (params_.polish && iteration_ != 0)
+        if (auto const Cost{ this->Polish(bestRoute_.get(), bestRoute_.get() + Count) }; Cost < best_)
+        {
+            best_ = Cost;
+            reporter_->Publish(iteration_, best_, bestRoute_.get());
+        }
+    reporter_->Close();
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910AntSystemPolicy<T, Graph, I>::UpdateChoice()
+{
+    if (this->Candidates().Empty())
+        UpdateChoiceInfo(
+            choice_,
+            pheromone_.Levels(),
+            heuristic_,
+            params_.a,
+            *executor_);
+    else
+        UpdateChoiceInfo(
+            candidateChoice_,
+            pheromone_.Levels(),
+            this->Candidates(),
+            candidateHeuristic_,
+            params_.a,
+            *executor_);
+}
+
+template<typename T, typename Graph, typename I>
+T CS3910AntSystemPolicy<T, Graph, I>::Choice(std::size_t x, std::size_t y) noexcept
+{
+    return ChoiceInfo(
+        pheromone_(x, y),
+        T(Weight(this->Env(), x, y)),
+        T(params_.a),
+        T(params_.b));
+}
+
+template<typename T, typename Graph, typename I>
+template<typename RandomIt, typename RngT>
+void CS3910AntSystemPolicy<T, Graph, I>::Construct(
+    RandomIt first,
+    RandomIt last,
+    RngT& rng,
+    double* desire,
+    I* positions)
+{
+    assert(first != last);
+
+    std::swap(*first, first[UniformIndex(rng, this->Env().Count())]);
+
+    // With candidate lists the positions of the cities tell which of the
+    // candidates are still unvisited, i.e. at or after first.
+    auto const& candidates{ this->Candidates() };
+    auto const Route{ first };
+    if (!candidates.Empty())
+        for (auto i{ first }; i != last; ++i)
+            positions[*i] = static_cast<I>(std::distance(Route, i));
+
+    while (first + 1 != last)
+    {
+        auto const pivot{ *(first++) };
+        auto const Remaining{ static_cast<std::size_t>(std::distance(first, last)) };
+        if (candidates.Empty())
+        {
+            // The weights line up with the remaining cities
+            for (std::size_t k{}; k != Remaining; ++k)
+                desire[k] = choice_(pivot, first[k]);
+
+            auto const Next{ RouletteIndex(desire, Remaining, rng) };
+            std::swap(*first, first[Next]);
+            continue;
+        }
+
+        auto const Visited{ static_cast<std::size_t>(std::distance(Route, first)) };
+        auto const Candidates{ candidates(pivot) };
+        auto const Choices{ candidateChoice_.data() + pivot * candidates.Size() };
+        for (std::size_t k{}; k != candidates.Size(); ++k)
+            desire[k] = positions[Candidates[k]] < Visited ? 0.0 : Choices[k];
+
+        // Choose among the candidates, or take the most desirable of the
+        // remaining cities once every candidate has been visited.
+        auto next{ first };
+        auto const Total{ SumWeights(desire, candidates.Size()) };
+        if (0.0 < Total)
+        {
+            auto const K{ SelectWeight(
+                desire,
+                candidates.Size(),
+                Total * UniformUnit(rng)) };
+            next = Route + positions[Candidates[K]];
+        }
+        else
+        {
+            // Each remaining city is weighed once, without a dense table
+            auto most{ T{-1} };
+            for (auto it{ first }; it != last; ++it)
+                if (auto const Value{ Choice(pivot, *it) }; most < Value)
+                {
+                    next = it;
+                    most = Value;
+                }
+        }
+
+        std::swap(*first, *next);
+        positions[*first] = static_cast<I>(std::distance(Route, first));
+        positions[*next] = static_cast<I>(std::distance(Route, next));
+    }
+}
+
+template<typename T, typename Graph, typename I>
+bool CS3910AntSystemPolicy<T, Graph, I>::Terminate() noexcept
+{
+    return params_.iterations < iteration_++;
+}
+
+template<typename T, typename Graph, typename I>
+T CS3910AntSystemPolicy<T, Graph, I>::Best() const noexcept
+{
+    return best_;
+}
+
+template<typename T, typename Graph, typename I>
+std::size_t CS3910AntSystemPolicy<T, Graph, I>::Evaluations() const noexcept
+{
+    return evaluations_;
+}
+
+#endif // !ANTSYSTEMPOLICY_H_
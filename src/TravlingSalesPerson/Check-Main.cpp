@@ -15,7 +15,8 @@ int main(int argc, char const** argv)
         return 0;
     }
 
-    TravlingSalesman<double> tsp{fileName};
+    // A single route needs only n distances, not the whole matrix
+    TravlingSalesman<double, EuclideanDistance<double>> tsp{fileName};
     argc -= 2;
     argv += 2;
 
@@ -0,0 +1,527 @@
+#ifndef EVOLUTIONPOLICY_H_
+#define EVOLUTIONPOLICY_H_
+
+#include "TravlingSalesman.h"
+#include "CS3910/Evolution.h"
+#include "CS3910/Simulation.h"
+#include "CS3910/Graph.h"
+#include "CS3910/Queue.h"
+#include "CS3910/Random.h"
+#include "CS3910/Report.h"
+#include "CS3910/Selection.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// How the islands pass their elites on.
+enum class MigrationTopology
+{
+    Ring, // Each island sends to the next
+    Random // Each island sends to another chosen at random
+};
+
+template<
+    typename T,
+    typename Graph = SymmetricMatrix<T>,
+    typename I = std::size_t>
+struct CS3910EvolutionPolicy : private TravlingSalesman<T, Graph>
+{
+public:
+    // The routes are rows of an island's route pool.
+    using value_type = struct
+    {
+        CostType<Graph> cost;
+        I* route;
+    };
+
+    struct Parameters
+    {
+        std::size_t k;
+        std::size_t populationSize;
+        std::size_t eliteSize;
+        std::size_t iterations; // Generations of every island
+        double randomGenerationProbabillity;
+        double mutationProbabillity;
+        NeighbourhoodMove mutation; // Swap two cities or reverse a segment
+        CrossoverOperator crossover;
+        std::size_t islands; // One per executor thread when zero, fix it to
+                             // make the results independent of the threads
+        std::size_t epochLength; // Generations between migrations
+        std::size_t migrants; // Elites each island sends per migration
+        MigrationTopology topology;
+        bool polish; // Polish the best route once the search completes
+        std::uint64_t seed; // Of every generator, random when zero
+    };
+
+    explicit CS3910EvolutionPolicy(
+        TravlingSalesman<T, Graph>&& problem,
+        Parameters const& params);
+
+    void Initialise(Executor& executor);
+
+    // Take in the migrants of the last epoch, then evolve every island for
+    // one epoch in parallel and send its elites on. The phases are apart, so
+    // the migrants an island sees never depend on the schedule.
+    void Step();
+
+    void Complete();
+
+    // The best cost found so far.
+    T Best() const noexcept;
+
+    // The number of routes costed so far.
+    std::size_t Evaluations() const noexcept;
+
+    bool Terminate();
+private:
+
+    template<typename RandomIt>
+    struct Selection
+    {
+        value_type& firstParent;
+        value_type& secondParent;
+        RandomIt nextIterator;
+    };
+
+    // Points into the outbox of the island that sent it
+    struct Migrant
+    {
+        CostType<Graph> cost;
+        I const* route;
+        std::size_t from;
+    };
+
+    // An independent population, only touched by one thread at a time
+    // except for its inbox.
+    struct Island
+    {
+        Philox4x32 rng{};
+
+        // One slab holds the rows of the population and of the offspring.
+        // The rows only change hands, so a generation allocates nothing.
+        std::unique_ptr<I[]> routes;
+
+        std::unique_ptr<value_type[]> population;
+
+        std::unique_ptr<value_type[]> offspring;
+
+        std::unique_ptr<double[]> fitness;
+
+        CrossoverWorkspace workspace;
+
+        std::vector<I const*> batch;
+
+        std::vector<CostType<Graph>> costs;
+
+        // Migrant rows, read by the receivers before they are refilled
+        std::unique_ptr<I[]> outbox;
+
+        std::unique_ptr<BoundedQueue<Migrant>> inbox;
+
+        std::vector<Migrant> arrivals;
+
+        double seconds; // Spent evolving
+    };
+
+    Executor* executor_;
+
+    std::unique_ptr<Reporter<I>> reporter_;
+
+    Parameters params_;
+
+    std::unique_ptr<Island[]> islands_;
+
+    double best_;
+
+    std::unique_ptr<I[]> bestRoute_;
+
+    std::size_t generation_;
+
+    template<typename RandomIt>
+    Selection<RandomIt> Select(
+        Island& island,
+        RandomIt first,
+        RandomIt last)
+    {
+        if(first + params_.k != last)
+        {
+            // Find the first parent
+            auto it = SampleGroup(first, last, params_.k, island.rng);
+            auto minIt = std::min_element(
+                first,
+                it,
+                [](auto& a, auto& b){ return a.cost < b.cost; });
+            std::swap(first[0], *minIt);
+
+            auto& parentA = first[0];
+
+            // Find the second parent
+            it = SampleGroup(first + 1, last, params_.k, island.rng);
+            minIt = std::min_element(
+                first + 1,
+                it,
+                [](auto& a, auto& b)
+                {
+                    return a.cost < b.cost;
+                });
+            std::swap(first[1], *minIt);
+        }
+
+        return Selection<RandomIt>{first[0], first[1], first + 2};
+    }
+
+    void Crossover(
+        Island& island,
+        value_type const& parentA,
+        value_type const& parentB,
+        value_type& childA,
+        value_type& childB)
+    {
+        auto const Offset = UniformIndex(island.rng, this->Env().Count());
+        auto const Length = UniformIndex(island.rng, this->Env().Count());
+
+        Recombine(
+            params_.crossover,
+            parentA.route,
+            parentA.route + this->Env().Count(),
+            parentB.route,
+            Offset,
+            Length,
+            childA.route,
+            island.workspace);
+
+        if(100.0 * UniformUnit(island.rng) <= params_.randomGenerationProbabillity)
+            Shuffle(
+                childA.route,
+                childA.route + this->Env().Count(),
+                island.rng);
+
+        Recombine(
+            params_.crossover,
+            parentB.route,
+            parentB.route + this->Env().Count(),
+            parentA.route,
+            Offset,
+            Length,
+            childB.route,
+            island.workspace);
+
+        if (100.0 * UniformUnit(island.rng) <= params_.randomGenerationProbabillity)
+            Shuffle(
+                childB.route,
+                childB.route + this->Env().Count(),
+                island.rng);
+    }
+
+    // Mutate a costed route, updating its cost by the change alone.
+    void Mutate(Island& island, value_type& value)
+    {
+        if(100.0 * UniformUnit(island.rng) > params_.mutationProbabillity)
+            return;
+        auto const Last{ value.route + this->Env().Count() };
+        value.cost += params_.mutation == NeighbourhoodMove::Swap
+            ? Opt2RandomSwap(this->Env(), value.route, Last, island.rng)
+            : Opt2RandomReverse(this->Env(), value.route, Last, island.rng);
+    }
+
+    // Cost every path in [first, last) with one batch call.
+    template<typename ForwardIt>
+    void Evaluate(Island& island, ForwardIt first, ForwardIt last)
+    {
+        island.batch.clear();
+        std::transform(
+            first,
+            last,
+            std::back_inserter(island.batch),
+            [](auto& path){ return path.route; });
+        island.costs.resize(island.batch.size());
+        CostOfEach(
+            this->Env(),
+            island.batch.data(),
+            island.batch.size(),
+            island.costs.data());
+        for (auto cost{ island.costs.begin() }; first != last; ++first, ++cost)
+            first->cost = *cost;
+    }
+
+    template<typename RandomIt>
+    void SelectNext(
+        Island& island,
+        RandomIt first,
+        RandomIt last)
+    {
+        auto const PopulationEnd = island.population.get() + params_.populationSize;
+        std::transform(
+            island.population.get(),
+            PopulationEnd,
+            island.fitness.get(),
+            [](auto& path){return 1 / path.cost;});
+
+        // Selection without replacement, the weights follow their paths
+        for(std::size_t i{}; i != params_.eliteSize; ++i)
+        {
+            auto const K = i + RouletteIndex(
+                island.fitness.get() + i,
+                params_.populationSize - i,
+                island.rng);
+            std::swap(island.population[i], island.population[K]);
+            std::swap(island.fitness[i], island.fitness[K]);
+        }
+
+        MoveRandom(
+            first,
+            last,
+            island.population.get() + params_.eliteSize,
+            PopulationEnd,
+            island.rng);
+    }
+
+    void Generation(Island& island);
+
+    void Immigrate(Island& island);
+
+    void Emigrate(Island& island, std::size_t id);
+};
+
+template<typename T, typename Graph, typename I>
+CS3910EvolutionPolicy<T, Graph, I>::CS3910EvolutionPolicy(
+    TravlingSalesman<T, Graph>&& problem,
+    Parameters const& params)
+    : TravlingSalesman<T, Graph>{ std::move(problem) }
+    , params_{params}
+{
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910EvolutionPolicy<T, Graph, I>::Initialise(Executor& executor)
+{
+    executor_ = &executor;
+    if (params_.islands == 0)
+        params_.islands = executor.Concurrency();
+    reporter_ = std::make_unique<Reporter<I>>(
+        this->Env().Count(),
+        [this](I const& x){ return std::string_view{ this->Node(x).name }; });
+    best_ = std::numeric_limits<double>::infinity();
+    generation_ = 0;
+    auto const Count{ this->Env().Count() };
+    bestRoute_ = std::make_unique<I[]>(Count);
+    islands_ = std::make_unique<Island[]>(params_.islands);
+
+    auto const Seed{ MasterSeed(params_.seed) };
+    std::for_each(
+        islands_.get(),
+        islands_.get() + params_.islands,
+        [&](auto& island)
+    {
+        island.rng.seed(Seed, &island - islands_.get());
+        island.routes = std::make_unique<I[]>(2 * params_.populationSize * Count);
+        island.population = std::make_unique<value_type[]>(params_.populationSize);
+        island.offspring = std::make_unique<value_type[]>(params_.populationSize);
+        island.fitness = std::make_unique<double[]>(params_.populationSize);
+        island.workspace = CrossoverWorkspace{Count};
+        island.batch.reserve(params_.populationSize);
+        island.costs.reserve(params_.populationSize);
+        island.outbox = std::make_unique<I[]>(params_.migrants * Count);
+        // Enough room for every island to send to this one
+        island.inbox = std::make_unique<BoundedQueue<Migrant>>(
+            params_.islands * params_.migrants);
+        island.arrivals.reserve(params_.islands * params_.migrants);
+        island.seconds = 0.0;
+
+        for (std::size_t i{}; i < params_.populationSize; ++i)
+        {
+            auto& path{ island.population[i] };
+            path.route = island.routes.get() + i * Count;
+            island.offspring[i].route =
+                island.routes.get() + (params_.populationSize + i) * Count;
+            std::iota(path.route, path.route + Count, 0);
+            Shuffle(path.route, path.route + Count, island.rng);
+        }
+
+        // The first population still lies row after row in the slab
+        island.costs.resize(params_.populationSize);
+        CostOfBlock(
+            this->Env(),
+            island.routes.get(),
+            Count,
+            params_.populationSize,
+            island.costs.data());
+        for (std::size_t i{}; i < params_.populationSize; ++i)
+            island.population[i].cost = island.costs[i];
+    });
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910EvolutionPolicy<T, Graph, I>::Step()
+{
+    auto const Generations{ std::min(
+        params_.epochLength,
+        params_.iterations - generation_) };
+    executor_->ParallelFor(0, params_.islands, [&](auto id)
+    {
+        Immigrate(islands_[id]);
+    });
+    executor_->ParallelFor(0, params_.islands, [&](auto id)
+    {
+        auto& island{ islands_[id] };
+        auto const Start{ std::chrono::steady_clock::now() };
+        for (std::size_t i{}; i != Generations; ++i)
+            Generation(island);
+        Emigrate(island, id);
+        island.seconds += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - Start).count();
+    });
+    generation_ += Generations;
+
+    value_type const* best{};
+    std::size_t source{};
+    for (std::size_t i{}; i != params_.islands; ++i)
+    {
+        auto const& island{ islands_[i] };
+        auto it = std::min_element(
+            island.population.get(),
+            island.population.get() + params_.populationSize,
+            [](auto& a, auto& b)
+            {
+                return a.cost < b.cost;
+            });
+        if (best == nullptr || it->cost < best->cost)
+        {
+            best = it;
+            source = i;
+        }
+    }
+
+    if (best != nullptr && best->cost < best_)
+    {
+        best_ = best->cost;
+        std::copy_n(best->route, this->Env().Count(), bestRoute_.get());
+        reporter_->Publish(generation_, best_, best->route, source);
+    }
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910EvolutionPolicy<T, Graph, I>::Complete()
+{
+    auto const Count{ this->Env().Count() };
+    if (params_.polish && generation_ != 0)
+        if (auto const Cost{ this->Polish(bestRoute_.get(), bestRoute_.get() + Count) }; Cost < best_)
+        {
+            best_ = Cost;
+            reporter_->Publish(generation_, best_, bestRoute_.get());
+        }
+    reporter_->Close();
+    for (std::size_t i{}; i != params_.islands; ++i)
+        std::cerr << "Island " << i << ": "
+            << generation_ / islands_[i].seconds << " generations/s\n";
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910EvolutionPolicy<T, Graph, I>::Generation(Island& island)
+{
+    auto const PopulationEnd{ island.population.get() + params_.populationSize };
+    auto child{ island.offspring.get() };
+    for (auto it{ island.population.get() }; it != PopulationEnd; child += 2)
+    {
+        auto [parentA, parentB, next] = Select(island, it, PopulationEnd);
+        it = next;
+
+        Crossover(island, parentA, parentB, child[0], child[1]);
+    }
+
+    Evaluate(island, island.offspring.get(), child);
+    for (auto it{ island.offspring.get() }; it != child; ++it)
+        Mutate(island, *it);
+    SelectNext(island, island.offspring.get(), child);
+}
+
+// Each migrant replaces the worst path of the island, if it is better. The
+// senders pushed at once, so the migrants are taken in order of sender.
+template<typename T, typename Graph, typename I>
+void CS3910EvolutionPolicy<T, Graph, I>::Immigrate(Island& island)
+{
+    Migrant arrival{};
+    island.arrivals.clear();
+    while (island.inbox->TryPop(arrival))
+        island.arrivals.push_back(arrival);
+    std::stable_sort(
+        island.arrivals.begin(),
+        island.arrivals.end(),
+        [](auto& a, auto& b){ return a.from < b.from; });
+
+    for (auto const& migrant : island.arrivals)
+    {
+        auto worst = std::max_element(
+            island.population.get(),
+            island.population.get() + params_.populationSize,
+            [](auto& a, auto& b)
+            {
+                return a.cost < b.cost;
+            });
+        if (migrant.cost < worst->cost)
+        {
+            worst->cost = migrant.cost;
+            std::copy_n(migrant.route, this->Env().Count(), worst->route);
+        }
+    }
+}
+
+// Copy the best paths of the island to its outbox and send them to the next
+// island of the topology.
+template<typename T, typename Graph, typename I>
+void CS3910EvolutionPolicy<T, Graph, I>::Emigrate(Island& island, std::size_t id)
+{
+    if (params_.islands < 2 || params_.migrants == 0)
+        return;
+
+    auto const Count{ this->Env().Count() };
+    auto const Migrants{ std::min(params_.migrants, params_.populationSize) };
+    std::partial_sort(
+        island.population.get(),
+        island.population.get() + Migrants,
+        island.population.get() + params_.populationSize,
+        [](auto& a, auto& b)
+        {
+            return a.cost < b.cost;
+        });
+
+    auto to{ id + 1 };
+    if (params_.topology == MigrationTopology::Random)
+        to += UniformIndex(island.rng, params_.islands - 1);
+    to %= params_.islands;
+
+    auto* const Outbox{ island.outbox.get() };
+    for (std::size_t i{}; i != Migrants; ++i)
+    {
+        auto const& path{ island.population[i] };
+        std::copy_n(path.route, Count, Outbox + i * Count);
+        islands_[to].inbox->TryPush(Migrant{path.cost, Outbox + i * Count, id});
+    }
+}
+
+template<typename T, typename Graph, typename I>
+bool CS3910EvolutionPolicy<T, Graph, I>::Terminate()
+{
+    return params_.iterations <= generation_;
+}
+
+template<typename T, typename Graph, typename I>
+T CS3910EvolutionPolicy<T, Graph, I>::Best() const noexcept
+{
+    return best_;
+}
+
+template<typename T, typename Graph, typename I>
+std::size_t CS3910EvolutionPolicy<T, Graph, I>::Evaluations() const noexcept
+{
+    return params_.islands * params_.populationSize * (generation_ + 1);
+}
+
+#endif // !EVOLUTIONPOLICY_H_
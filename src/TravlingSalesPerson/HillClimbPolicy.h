@@ -0,0 +1,252 @@
+#ifndef HILLCLIMBPOLICY_H_
+#define HILLCLIMBPOLICY_H_
+
+#include "TravlingSalesman.h"
+#include "CS3910/Graph.h"
+#include "CS3910/Neighbourhood.h"
+#include "CS3910/Random.h"
+#include "CS3910/Report.h"
+#include "CS3910/Simulation.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <utility>
+
+// Restarts run in parallel, each worker claiming the next restart when it
+// is free, and the best route found is shared by all of them. Every restart
+// draws from its own stream and ties go to the earlier restart, so the
+// result does not depend on the number of workers. When the problem has
+// candidate lists the descent only tries moves towards the candidates.
+template<
+    typename T,
+    typename Graph = SymmetricMatrix<T>,
+    typename I = std::size_t>
+class CS3910HillClimbPolicy final : private TravlingSalesman<T, Graph>
+{
+public:
+    using value_type = struct
+    {
+        CostType<Graph> cost;
+        std::unique_ptr<I[]> route;
+    };
+
+    struct Parameters
+    {
+        std::size_t iterations; // Restarts in total
+        NeighbourhoodMove move;
+        ImprovementStrategy strategy;
+        std::size_t workers; // One per executor thread when zero
+        T target; // Stop once a route this short is found, never when zero
+        std::uint64_t seed; // Of every generator, random when zero
+    };
+
+    explicit CS3910HillClimbPolicy(
+        TravlingSalesman<T, Graph>&& problem,
+        Parameters const& params);
+
+    void Initialise(Executor& executor);
+
+    // Run restarts on every worker until none are left to claim.
+    void Step();
+
+    void Complete();
+
+    // The best cost found so far.
+    T Best() const noexcept;
+
+    // The number of restarts, each a local search, completed so far.
+    std::size_t Evaluations() const noexcept;
+
+    bool Terminate();
+private:
+    struct Worker
+    {
+        value_type x;
+
+        std::unique_ptr<I[]> positions;
+
+        std::size_t restarts;
+    };
+
+    std::unique_ptr<Worker[]> workers_;
+
+    Executor* executor_;
+
+    std::atomic<std::size_t> next_;
+
+    std::atomic<T> best_;
+
+    // Guards bestRoute_, its cost and restart and the order of reports
+    std::mutex publish_;
+
+    std::unique_ptr<I[]> bestRoute_;
+
+    CostType<Graph> bestCost_;
+
+    std::size_t bestRestart_;
+
+    std::uint64_t seed_;
+
+    std::unique_ptr<Reporter<I>> reporter_;
+
+    Parameters params_;
+
+    void Restart(Worker& worker, std::size_t restart);
+
+    void Publish(Worker const& worker, std::size_t restart);
+};
+
+template<typename T, typename Graph, typename I>
+CS3910HillClimbPolicy<T, Graph, I>::CS3910HillClimbPolicy(
+    TravlingSalesman<T, Graph>&& problem,
+    Parameters const& params)
+    : TravlingSalesman<T, Graph>{ std::move(problem) }
+    , params_{params}
+{
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910HillClimbPolicy<T, Graph, I>::Initialise(Executor& executor)
+{
+    auto const Count{ this->Env().Count() };
+    executor_ = &executor;
+    reporter_ = std::make_unique<Reporter<I>>(
+        Count,
+        [this](I const& x){ return std::string_view{ this->Node(x).name }; });
+    if (params_.workers == 0)
+        params_.workers = executor.Concurrency();
+    next_ = 0;
+    best_ = std::numeric_limits<T>::infinity();
+    bestRoute_ = std::make_unique<I[]>(Count);
+    bestCost_ = std::numeric_limits<CostType<Graph>>::max();
+    bestRestart_ = params_.iterations;
+    seed_ = MasterSeed(params_.seed);
+    workers_ = std::make_unique<Worker[]>(params_.workers);
+
+    std::for_each(
+        workers_.get(),
+        workers_.get() + params_.workers,
+        [&](auto& worker)
+        {
+            worker.x = {{}, std::make_unique<I[]>(Count)};
+            worker.positions = std::make_unique<I[]>(Count);
+            worker.restarts = 0;
+        });
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910HillClimbPolicy<T, Graph, I>::Step()
+{
+    executor_->ParallelFor(0, params_.workers, [&](auto i)
+    {
+        auto& worker{ workers_[i] };
+        for (auto restart{ next_++ }; restart < params_.iterations; restart = next_++)
+        {
+            Restart(worker, restart);
+            ++worker.restarts;
+        }
+    });
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910HillClimbPolicy<T, Graph, I>::Restart(Worker& worker, std::size_t restart)
+{
+    auto& x{ worker.x };
+    Philox4x32 rng{ seed_, restart };
+    std::iota(x.route.get(), x.route.get() + this->Env().Count(), 0);
+    Shuffle(x.route.get() + 1, x.route.get() + this->Env().Count(), rng);
+    if (this->Candidates().Empty())
+        Descend(
+            this->Env(),
+            x.route.get(),
+            x.route.get() + this->Env().Count(),
+            params_.move,
+            params_.strategy);
+    else
+        Descend(
+            this->Env(),
+            this->Candidates(),
+            x.route.get(),
+            x.route.get() + this->Env().Count(),
+            worker.positions.get(),
+            params_.move,
+            params_.strategy);
+
+    x.cost = CostOf(
+        this->Env(),
+        x.route.get(),
+        x.route.get() + this->Env().Count());
+
+    auto best{ best_.load(std::memory_order_relaxed) };
+    while (x.cost <= best)
+        if (best_.compare_exchange_weak(best, x.cost, std::memory_order_relaxed))
+        {
+            Publish(worker, restart);
+            break;
+        }
+}
+
+// Report the route of a worker that has just lowered or matched best_,
+// unless another worker has since found a shorter route or an earlier
+// restart the same length.
+template<typename T, typename Graph, typename I>
+void CS3910HillClimbPolicy<T, Graph, I>::Publish(
+    Worker const& worker,
+    std::size_t restart)
+{
+    std::lock_guard<std::mutex> lock{ publish_ };
+    auto const Best{ best_.load(std::memory_order_relaxed) };
+    if (Best < worker.x.cost
+        || (worker.x.cost == bestCost_ && bestRestart_ < restart))
+        return;
+
+    bestCost_ = worker.x.cost;
+    bestRestart_ = restart;
+    std::copy_n(worker.x.route.get(), this->Env().Count(), bestRoute_.get());
+    reporter_->Publish(
+        restart,
+        worker.x.cost,
+        bestRoute_.get(),
+        &worker - workers_.get());
+
+    // The other workers stop claiming restarts once the target is reached
+    if (worker.x.cost <= params_.target)
+        next_ = params_.iterations;
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910HillClimbPolicy<T, Graph, I>::Complete()
+{
+    reporter_->Close();
+    for (std::size_t i{}; i != params_.workers; ++i)
+        std::cerr << "Worker " << i << ": " << workers_[i].restarts << " restarts\n";
+}
+
+template<typename T, typename Graph, typename I>
+bool CS3910HillClimbPolicy<T, Graph, I>::Terminate()
+{
+    return params_.iterations <= next_;
+}
+
+template<typename T, typename Graph, typename I>
+T CS3910HillClimbPolicy<T, Graph, I>::Best() const noexcept
+{
+    return best_.load(std::memory_order_relaxed);
+}
+
+template<typename T, typename Graph, typename I>
+std::size_t CS3910HillClimbPolicy<T, Graph, I>::Evaluations() const noexcept
+{
+    std::size_t restarts{};
+    for (std::size_t i{}; i != params_.workers; ++i)
+        restarts += workers_[i].restarts;
+    return restarts;
+}
+
+#endif // !HILLCLIMBPOLICY_H_
@@ -0,0 +1,67 @@
+#include "LocalSearchPolicy.h"
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+LocalSearchMove ParseLocalSearchMove(char const* name) noexcept
+{
+    if (std::strcmp(name, "2opt") == 0)
+        return LocalSearchMove::Opt2;
+    if (std::strcmp(name, "oropt") == 0)
+        return LocalSearchMove::OrOpt;
+    return LocalSearchMove::LinKernighan;
+}
+
+int main(int argc, char const** argv)
+{
+    char const* fileName = "sample/ulysses16.csv";
+    if(1 < argc)
+        fileName = argv[1];
+    else
+        std::cerr << "No input file provided as argument 1\n"
+            << "Argument 2 may select matrix, float, int, implicit, cached, mapped or "
+            << "mappedfloat distances\n"
+            << "Argument 3 may select the 2opt, oropt or lk moves\n"
+            << "running iterated local search using " << fileName << '\n';
+
+    auto const Mode{ 2 < argc
+        ? ParseDistanceMode(argv[2])
+        : DistanceMode::Matrix };
+
+    auto const Move{ 3 < argc
+        ? ParseLocalSearchMove(argv[3])
+        : LocalSearchMove::LinKernighan };
+
+    // Nearest neighbours per city, the moves only reach these
+    std::size_t const Candidates{ 10 };
+
+    auto const Seed{ MasterSeedFromEnvironment() };
+
+    std::cerr << "Running...\n";
+    WithDistanceMode<double>(Mode, [=](auto graph)
+    {
+        using Graph = typename decltype(graph)::type;
+        TravlingSalesman<double, Graph> problem{ fileName, Candidates };
+        auto const Count{ problem.Env().Count() };
+        WithRouteIndex(Count, [&](auto index)
+        {
+            using I = typename decltype(index)::type;
+            WithTour<I>(Count, [&](auto tour)
+            {
+                using LocalSearchPolicy = CS3910LocalSearchPolicy<
+                    double,
+                    Graph,
+                    I,
+                    typename decltype(tour)::type>;
+                typename LocalSearchPolicy::Parameters params{};
+                params.iterations = 100000;
+                params.move = Move;
+                params.workers = 0;
+                params.target = 0.0;
+                params.seed = Seed;
+
+                Simulate(LocalSearchPolicy{std::move(problem), params});
+            });
+        });
+    });
+}
@@ -0,0 +1,207 @@
+#ifndef LOCALSEARCHPOLICY_H_
+#define LOCALSEARCHPOLICY_H_
+
+#include "TravlingSalesman.h"
+#include "CS3910/Graph.h"
+#include "CS3910/LocalSearch.h"
+#include "CS3910/Random.h"
+#include "CS3910/Report.h"
+#include "CS3910/Simulation.h"
+#include "CS3910/Tour.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Iterated local search. The route starts as a nearest neighbour route
+// taken to a local optimum, then every step each worker kicks its own copy
+// of the best route KICKS times from its own stream, searches around the
+// kick and keeps it when the route got shorter. The best worker's route is
+// the start of the next step, ties going to the lowest worker, so the
+// result depends on the number of workers but not on the threads. The
+// problem must have candidate lists. Tour is the representation the workers
+// search, see WithTour.
+template<
+    typename T,
+    typename Graph = SymmetricMatrix<T>,
+    typename I = std::size_t,
+    typename Tour = ArrayTour<I>>
+class CS3910LocalSearchPolicy final : private TravlingSalesman<T, Graph>
+{
+public:
+    using Search = LocalSearch<Graph, Tour>;
+
+    using value_type = struct
+    {
+        typename Search::cost_type cost;
+        std::unique_ptr<I[]> route;
+    };
+
+    struct Parameters
+    {
+        std::size_t iterations; // Kicks in total
+        LocalSearchMove move;
+        std::size_t workers; // One per executor thread when zero
+        T target; // Stop once a route this short is found, never when zero
+        std::uint64_t seed; // Of every generator, random when zero
+    };
+
+    explicit CS3910LocalSearchPolicy(
+        TravlingSalesman<T, Graph>&& problem,
+        Parameters const& params);
+
+    void Initialise(Executor& executor);
+
+    // Kick the best route KICKS times on every worker.
+    void Step();
+
+    void Complete();
+
+    // The best cost found so far.
+    T Best() const noexcept;
+
+    // The number of kicks tried so far.
+    std::size_t Evaluations() const noexcept;
+
+    bool Terminate();
+private:
+    static constexpr std::size_t KICKS{ 64 };
+
+    struct Worker
+    {
+        Tour tour;
+
+        Search search;
+
+        typename Search::cost_type cost;
+    };
+
+    std::vector<Worker> workers_;
+
+    Executor* executor_;
+
+    value_type best_;
+
+    // The best worker's route while it is costed afresh
+    std::unique_ptr<I[]> route_;
+
+    std::size_t iteration_;
+
+    std::uint64_t seed_;
+
+    std::unique_ptr<Reporter<I>> reporter_;
+
+    Parameters params_;
+};
+
+template<typename T, typename Graph, typename I, typename Tour>
+CS3910LocalSearchPolicy<T, Graph, I, Tour>::CS3910LocalSearchPolicy(
+    TravlingSalesman<T, Graph>&& problem,
+    Parameters const& params)
+    : TravlingSalesman<T, Graph>{ std::move(problem) }
+    , params_{params}
+{
+}
+
+template<typename T, typename Graph, typename I, typename Tour>
+void CS3910LocalSearchPolicy<T, Graph, I, Tour>::Initialise(Executor& executor)
+{
+    auto const Count{ this->Env().Count() };
+    executor_ = &executor;
+    reporter_ = std::make_unique<Reporter<I>>(
+        Count,
+        [this](I const& x){ return std::string_view{ this->Node(x).name }; });
+    if (params_.workers == 0)
+        params_.workers = executor.Concurrency();
+    iteration_ = 0;
+    seed_ = MasterSeed(params_.seed);
+
+    workers_.clear();
+    workers_.reserve(params_.workers);
+    for (std::size_t i{}; i < params_.workers; ++i)
+        workers_.push_back({
+            Tour{Count},
+            Search{this->Env(), this->Candidates(), params_.move},
+            {}});
+
+    best_ = {{}, std::make_unique<I[]>(Count)};
+    route_ = std::make_unique<I[]>(Count);
+    auto const Route{ best_.route.get() };
+    std::iota(Route, Route + Count, 0);
+    NearestNeighbourRoute(this->Env(), this->Candidates(), Route, Route + Count);
+    ImproveRoute(this->Env(), this->Candidates(), Route, Route + Count, params_.move);
+    best_.cost = CostOf(this->Env(), Route, Route + Count);
+    reporter_->Publish(0, best_.cost, Route);
+}
+
+template<typename T, typename Graph, typename I, typename Tour>
+void CS3910LocalSearchPolicy<T, Graph, I, Tour>::Step()
+{
+    auto const Round{ iteration_ / (KICKS * params_.workers) };
+    executor_->ParallelFor(0, params_.workers, [&](auto i)
+    {
+        auto& [tour, search, cost] = workers_[i];
+        Philox4x32 rng{ seed_, Round * params_.workers + i };
+        tour.Assign(best_.route.get());
+        cost = best_.cost;
+        for (std::size_t kick{}; kick < KICKS; ++kick)
+        {
+            search.Commit();
+            auto delta{ search.Kick(tour, rng) };
+            delta += search.Run(tour);
+            if (delta < -search.Epsilon())
+                cost += delta;
+            else
+                search.Rollback(tour);
+        }
+    });
+    iteration_ += KICKS * params_.workers;
+
+    auto const Best{ std::min_element(
+        workers_.begin(),
+        workers_.end(),
+        [](auto const& x, auto const& y){ return x.cost < y.cost; }) };
+    if (!(Best->cost < best_.cost))
+        return;
+
+    // The costs were summed move by move, so the route is costed afresh and
+    // only replaces the best when it really is shorter
+    auto const Count{ this->Env().Count() };
+    Best->tour.Copy(route_.get(), best_.route[0]);
+    auto const Cost{ CostOf(this->Env(), route_.get(), route_.get() + Count) };
+    if (!(Cost < best_.cost))
+        return;
+    best_.cost = Cost;
+    std::swap(best_.route, route_);
+    reporter_->Publish(iteration_, best_.cost, best_.route.get(), Best - workers_.begin());
+}
+
+template<typename T, typename Graph, typename I, typename Tour>
+void CS3910LocalSearchPolicy<T, Graph, I, Tour>::Complete()
+{
+    reporter_->Close();
+}
+
+template<typename T, typename Graph, typename I, typename Tour>
+bool CS3910LocalSearchPolicy<T, Graph, I, Tour>::Terminate()
+{
+    return params_.iterations <= iteration_ || best_.cost <= params_.target;
+}
+
+template<typename T, typename Graph, typename I, typename Tour>
+T CS3910LocalSearchPolicy<T, Graph, I, Tour>::Best() const noexcept
+{
+    return best_.cost;
+}
+
+template<typename T, typename Graph, typename I, typename Tour>
+std::size_t CS3910LocalSearchPolicy<T, Graph, I, Tour>::Evaluations() const noexcept
+{
+    return iteration_;
+}
+
+#endif // !LOCALSEARCHPOLICY_H_
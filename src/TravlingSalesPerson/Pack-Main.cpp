@@ -0,0 +1,70 @@
+#include "TravlingSalesman.h"
+#include "CS3910/PackedProblem.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+int main(int argc, char const** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "Pass the problem to pack as argument 1 and the packed "
+            << "file to write as argument 2\n"
+            << "Argument 3 is the number of candidates per node, 10 when absent\n"
+            << "Argument 4 may select a none, double or float matrix, double "
+            << "when absent\n";
+        return 0;
+    }
+
+    std::size_t candidates{ 10 };
+    if (3 < argc)
+        std::istringstream{argv[3]} >> candidates;
+
+    auto matrixType{ PackedMatrix::Double };
+    if (4 < argc && std::strcmp(argv[4], "none") == 0)
+        matrixType = PackedMatrix::None;
+    else if (4 < argc && std::strcmp(argv[4], "float") == 0)
+        matrixType = PackedMatrix::Float;
+
+    // The distances follow from the coordinates and the metric of the problem
+    TravlingSalesman<double, EuclideanDistance<double>> problem{ argv[1], candidates };
+    auto const Nodes{ problem.Nodes() };
+    auto const Count{ problem.Env().Count() };
+    if (Count == 0)
+    {
+        std::cerr << argv[1] << " has no nodes to pack\n";
+        return EXIT_FAILURE;
+    }
+    SymmetricMatrix<double> doubles{ 0 };
+    SymmetricMatrix<float> floats{ 0 };
+    void const* matrix{};
+    if (matrixType == PackedMatrix::Double)
+    {
+        doubles = DistanceMatrix<double>(Nodes, Nodes + Count, problem.DistanceMetric());
+        matrix = doubles.Data();
+    }
+    else if (matrixType == PackedMatrix::Float)
+    {
+        floats = DistanceMatrix<float>(Nodes, Nodes + Count, problem.DistanceMetric());
+        matrix = floats.Data();
+    }
+
+    std::ofstream file{ argv[2], std::ios::binary };
+    if (!WritePackedProblem(
+        file,
+        Nodes,
+        Nodes + Count,
+        problem.DistanceMetric(),
+        problem.Candidates(),
+        matrixType,
+        matrix))
+    {
+        std::cerr << "Could not write " << argv[2] << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Packed " << Count << " nodes with "
+        << problem.Candidates().Size() << " candidates each into " << argv[2] << '\n';
+}
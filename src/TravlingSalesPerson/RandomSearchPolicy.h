@@ -0,0 +1,171 @@
+#ifndef RANDOMSEARCHPOLICY_H_
+#define RANDOMSEARCHPOLICY_H_
+
+#include "TravlingSalesman.h"
+#include "CS3910/Graph.h"
+#include "CS3910/Random.h"
+#include "CS3910/Report.h"
+#include "CS3910/Simulation.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+
+template<
+    typename T,
+    typename Graph = SymmetricMatrix<T>,
+    typename I = std::size_t>
+class CS3910RandomSearchPolicy final : private TravlingSalesman<T, Graph>
+{
+public:
+    using value_type = struct
+    {
+        CostType<Graph> cost;
+        std::unique_ptr<I[]> route;
+    };
+
+    struct Parameters
+    {
+        std::size_t iterations;
+        bool polish; // Polish the best route once the search completes
+        std::uint64_t seed; // Of every generator, random when zero
+    };
+
+    explicit CS3910RandomSearchPolicy(
+        TravlingSalesman<T, Graph>&& problem,
+        Parameters const& params);
+
+    void Initialise(Executor& executor);
+
+    // Draw SAMPLES routes in parallel.
+    void Step();
+
+    void Complete();
+
+    // The best cost found so far.
+    T Best() const noexcept;
+
+    // The number of routes costed so far.
+    std::size_t Evaluations() const noexcept;
+
+    bool Terminate();
+private:
+    // Each sample draws from its own stream, so a fixed number of them makes
+    // the routes independent of the number of threads.
+    static constexpr std::size_t SAMPLES{ 64 };
+
+    struct Sample
+    {
+        value_type x;
+
+        Philox4x32 rng{};
+    };
+
+    std::unique_ptr<Sample[]> samples_;
+
+    Executor* executor_;
+
+    std::unique_ptr<Reporter<I>> reporter_;
+
+    std::size_t iteration_{};
+
+    double best_;
+
+    std::unique_ptr<I[]> bestRoute_;
+
+    Parameters params_;
+};
+
+template<typename T, typename Graph, typename I>
+CS3910RandomSearchPolicy<T, Graph, I>::CS3910RandomSearchPolicy(
+    TravlingSalesman<T, Graph>&& problem,
+    Parameters const& params)
+    : TravlingSalesman<T, Graph>{ std::move(problem) }
+    , params_{params}
+{
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910RandomSearchPolicy<T, Graph, I>::Initialise(Executor& executor)
+{
+    auto const Count{ this->Env().Count() };
+    executor_ = &executor;
+    iteration_ = 0;
+    best_ = std::numeric_limits<double>::infinity();
+    bestRoute_ = std::make_unique<I[]>(Count);
+    std::iota(bestRoute_.get(), bestRoute_.get() + Count, 0);
+    samples_ = std::make_unique<Sample[]>(SAMPLES);
+    reporter_ = std::make_unique<Reporter<I>>(
+        this->Env().Count(),
+        [this](I const& x){ return std::string_view{ this->Node(x).name }; });
+
+    auto const Seed{ MasterSeed(params_.seed) };
+    for (std::size_t i{}; i < SAMPLES; ++i)
+    {
+        auto& sample{ samples_[i] };
+        sample.rng.seed(Seed, i);
+        sample.x = {{}, std::make_unique<I[]>(Count)};
+        std::iota(sample.x.route.get(), sample.x.route.get() + Count, 0);
+    }
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910RandomSearchPolicy<T, Graph, I>::Step()
+{
+    auto const Count{ this->Env().Count() };
+    auto const Samples{ std::min(SAMPLES, params_.iterations - iteration_) };
+    executor_->ParallelFor(0, Samples, [&](auto i)
+    {
+        auto& [x, rng] = samples_[i];
+        Shuffle(x.route.get() + 1, x.route.get() + Count, rng);
+        x.cost = CostOf(this->Env(), x.route.get(), x.route.get() + Count);
+    });
+
+    for (std::size_t i{}; i < Samples; ++i)
+    {
+        auto const& x{ samples_[i].x };
+        if (x.cost < best_)
+        {
+            best_ = x.cost;
+            std::copy_n(x.route.get(), Count, bestRoute_.get());
+            reporter_->Publish(iteration_ + i + 1, best_, x.route.get());
+        }
+    }
+    iteration_ += Samples;
+}
+
+template<typename T, typename Graph, typename I>
+void CS3910RandomSearchPolicy<T, Graph, I>::Complete()
+{
+    auto const Count{ this->Env().Count() };
+    if (params_.polish && iteration_ != 0)
+        if (auto const Cost{ this->Polish(bestRoute_.get(), bestRoute_.get() + Count) }; Cost < best_)
+        {
+            best_ = Cost;
+            reporter_->Publish(iteration_, best_, bestRoute_.get());
+        }
+    reporter_->Close();
+}
+
+template<typename T, typename Graph, typename I>
+bool CS3910RandomSearchPolicy<T, Graph, I>::Terminate()
+{
+    return params_.iterations <= iteration_;
+}
+
+template<typename T, typename Graph, typename I>
+T CS3910RandomSearchPolicy<T, Graph, I>::Best() const noexcept
+{
+    return best_;
+}
+
+template<typename T, typename Graph, typename I>
+std::size_t CS3910RandomSearchPolicy<T, Graph, I>::Evaluations() const noexcept
+{
+    return iteration_;
+}
+
+#endif // !RANDOMSEARCHPOLICY_H_
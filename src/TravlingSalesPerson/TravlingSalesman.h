@@ -1,34 +1,396 @@
 #ifndef TRAVLINGSALESMAN_H_
 #define TRAVLINGSALESMAN_H_
 
+#include "CS3910/Candidates.h"
+#include "CS3910/Distance.h"
+#include "CS3910/Executor.h"
 #include "CS3910/Graph.h"
+#include "CS3910/LocalSearch.h"
+#include "CS3910/MappedFile.h"
+#include "CS3910/PackedProblem.h"
+#include <algorithm>
+#include <cassert>
+#include <charconv>
 #include <cmath>
-#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace internal
 {
-    template<typename OutputIt, typename Extraction>
-    void ReadTravlingSalesmanData(
+    // Text at least this long is split into chunks parsed on many threads
+    constexpr std::size_t PARSE_CHUNK_SIZE{ std::size_t{1} << 20 };
+
+    inline std::string_view Trim(std::string_view text) noexcept
+    {
+        auto const First{ text.find_first_not_of(" \t\r") };
+        if (First == std::string_view::npos)
+            return {};
+        return text.substr(First, text.find_last_not_of(" \t\r") - First + 1);
+    }
+
+    // Remove and return the first line of text, without the line break.
+    inline std::string_view NextLine(std::string_view& text) noexcept
+    {
+        auto const Break{ text.find('\n') };
+        auto const Line{ text.substr(0, Break) };
+        text.remove_prefix(Break == std::string_view::npos ? text.size() : Break + 1);
+        return Line;
+    }
+
+    // Parse the number at the front of text, after any blanks, and remove it.
+    template<typename T>
+    bool ParseNumber(std::string_view& text, T& value) noexcept
+    {
+        text = Trim(text);
+        if (!text.empty() && text.front() == '+')
+            text.remove_prefix(1);
+        auto const [End, Error] = std::from_chars(
+            text.data(),
+            text.data() + text.size(),
+            value);
+        if (Error != std::errc{})
+            return false;
+        text.remove_prefix(End - text.data());
+        return true;
+    }
+
+    // A line of name,x,y.
+    template<typename NodeInfo>
+    bool ParseCsvNode(std::string_view line, NodeInfo& node)
+    {
+        auto const Comma{ line.find(',') };
+        if (Comma == std::string_view::npos)
+            return false;
+        node.name = Trim(line.substr(0, Comma));
+        line.remove_prefix(Comma + 1);
+        if (!ParseNumber(line, node.x))
+            return false;
+        line = Trim(line);
+        if (line.empty() || line.front() != ',')
+            return false;
+        line.remove_prefix(1);
+        return ParseNumber(line, node.y);
+    }
+
+    // A line of id x y in the NODE_COORD_SECTION of a TSPLIB problem.
+    template<typename NodeInfo>
+    bool ParseTsplibNode(std::string_view line, NodeInfo& node)
+    {
+        line = Trim(line);
+        auto const Blank{ line.find_first_of(" \t") };
+        if (Blank == std::string_view::npos)
+            return false;
+        node.name = line.substr(0, Blank);
+        line.remove_prefix(Blank);
+        return ParseNumber(line, node.x) && ParseNumber(line, node.y);
+    }
+
+    // Parse a node from every line of text that is not blank, up to the
+    // first line parse rejects. Long text is split into chunks at line
+    // breaks and the chunks are parsed in parallel on an executor made with
+    // options.
+    template<typename NodeInfo, typename Parse>
+    std::vector<NodeInfo> ParseNodes(
+        std::string_view text,
+        Parse parse,
+        ExecutorOptions const& options)
+    {
+        std::vector<std::string_view> chunks{};
+        while (!text.empty())
+        {
+            auto const Break{ text.size() <= PARSE_CHUNK_SIZE
+                ? std::string_view::npos
+                : text.find('\n', PARSE_CHUNK_SIZE) };
+            auto const Size{ Break == std::string_view::npos ? text.size() : Break + 1 };
+            chunks.push_back(text.substr(0, Size));
+            text.remove_prefix(Size);
+        }
+
+        struct Chunk
+        {
+            std::vector<NodeInfo> nodes;
+            bool ended; // At a line that is not a node
+        };
+        std::vector<Chunk> parsed(chunks.size());
+        auto const ParseChunk{ [&](std::size_t i)
+        {
+            auto& [nodes, ended] = parsed[i];
+            auto rest{ chunks[i] };
+            nodes.reserve(std::count(rest.begin(), rest.end(), '\n') + 1);
+            ended = false;
+            NodeInfo node{};
+            while (!rest.empty() && !ended)
+            {
+                auto const Line{ NextLine(rest) };
+                if (Trim(Line).empty())
+                    continue;
+                if (parse(Line, node))
+                    nodes.push_back(std::move(node));
+                else
+                    ended = true;
+            }
+        } };
+
+        if (chunks.size() < 2)
+            for (std::size_t i{}; i < chunks.size(); ++i)
+                ParseChunk(i);
+        else
+        {
+            Executor executor{ options };
+            executor.ParallelFor(0, chunks.size(), ParseChunk);
+        }
+
+        if (parsed.size() == 1)
+            return std::move(parsed.front().nodes);
+
+        std::size_t count{};
+        for (auto const& chunk : parsed)
+            count += chunk.nodes.size();
+        std::vector<NodeInfo> nodes{};
+        nodes.reserve(count);
+        for (auto& chunk : parsed)
+        {
+            std::move(chunk.nodes.begin(), chunk.nodes.end(), std::back_inserter(nodes));
+            if (chunk.ended)
+                break;
+        }
+        return nodes;
+    }
+
+    template<typename NodeInfo>
+    struct ProblemData
+    {
+        std::vector<NodeInfo> nodes;
+        Metric metric;
+        std::optional<PackedProblem> packed; // Of packed problem files
+    };
+
+    // Read the nodes and metric of a problem in any format: lines of
+    // name,x,y, a TSPLIB problem with a NODE_COORD_SECTION, whose metric is
+    // read from its EDGE_WEIGHT_TYPE, or a packed problem. Long text is parsed
+    // on the threads of options.
+    template<typename NodeInfo>
+    ProblemData<NodeInfo> ReadTravlingSalesmanData(
         char const* fileName,
-        OutputIt outIt,
-        Extraction&& extract)
+        ExecutorOptions const& options)
     {
         assert(fileName != nullptr);
-        std::ifstream file{};
-        file.open(fileName);
+        auto const File{ std::make_shared<MappedFile const>(fileName) };
+        if (!File->IsOpen())
+        {
+            std::cerr << "Could not open " << fileName << '\n';
+            return {{}, Metric::Euclidean, std::nullopt};
+        }
+
+        if (auto packed{ PackedProblem::Open(File) })
+        {
+            std::vector<NodeInfo> nodes(packed->Count());
+            for (std::size_t i{}; i < nodes.size(); ++i)
+            {
+                nodes[i].name = packed->Name(i);
+                nodes[i].x = packed->X(i);
+                nodes[i].y = packed->Y(i);
+            }
+            return {std::move(nodes), packed->DistanceMetric(), std::move(packed)};
+        }
 
-        if (!file.is_open())
-            /* Error */;
+        auto text{ File->Text() };
+        auto first{ text };
+        while (!first.empty() && Trim(first.substr(0, first.find('\n'))).empty())
+            NextLine(first);
+        NodeInfo node{};
+        if (first.empty() || ParseCsvNode(NextLine(first), node))
+            return {
+                ParseNodes<NodeInfo>(text, &ParseCsvNode<NodeInfo>, options),
+                Metric::Euclidean,
+                std::nullopt};
 
-        while (extract(file, *outIt))
-            ++outIt;
+        // The specification is KEY : VALUE lines up to the first section
+        auto metric{ Metric::Euc2D };
+        while (!text.empty())
+        {
+            auto const Line{ Trim(NextLine(text)) };
+            if (Line.substr(0, 18) == "NODE_COORD_SECTION")
+                return {
+                    ParseNodes<NodeInfo>(text, &ParseTsplibNode<NodeInfo>, options),
+                    metric,
+                    std::nullopt};
+
+            auto const Colon{ Line.find(':') };
+            if (Colon == std::string_view::npos)
+                continue;
+            auto const Key{ Trim(Line.substr(0, Colon)) };
+            auto const Value{ Trim(Line.substr(Colon + 1)) };
+            if (Key != "EDGE_WEIGHT_TYPE")
+                continue;
+            if (Value == "GEO")
+                metric = Metric::Geo;
+            else if (Value == "ATT")
+                metric = Metric::Att;
+            else if (Value != "EUC_2D")
+                std::cerr << "EDGE_WEIGHT_TYPE " << Value
+                    << " is not supported, using EUC_2D\n";
+        }
+
+        std::cerr << fileName << " has no NODE_COORD_SECTION\n";
+        return {{}, metric, std::nullopt};
     }
+
+    // Rows of the distance matrix handed to a thread at a time
+    constexpr std::size_t DISTANCE_ROW_TILE{ 64 };
+
+    // Columns of a row tile computed at a time, whose coordinates stay in L1
+    constexpr std::size_t DISTANCE_COLUMN_TILE{ 1024 };
 }
 
-template<typename T>
+// Every distance between the nodes [first, last) under metric. The matrix is
+// built in tiles of rows spread over the threads of options, each filled a
+// tile of columns at a time.
+template<typename V, typename ForwardIt>
+SymmetricMatrix<V> DistanceMatrix(
+    ForwardIt first,
+    ForwardIt last,
+    Metric metric,
+    ExecutorOptions const& options = ExecutorOptions::FromEnvironment())
+{
+    using internal::DISTANCE_COLUMN_TILE;
+    using internal::DISTANCE_ROW_TILE;
+    std::vector<double> xs{};
+    std::vector<double> ys{};
+    for (; first != last; ++first)
+    {
+        xs.push_back(first->x);
+        ys.push_back(first->y);
+    }
+
+    auto const Count{ xs.size() };
+    SymmetricMatrix<V> matrix{ Count };
+    auto const Data{ matrix.Data() };
+    auto const FillTile{ [&](std::size_t tile)
+    {
+        // Row x is stored from (x, 0) to the zero of (x, x)
+        auto const From{ tile * DISTANCE_ROW_TILE };
+        auto const To{ std::min(Count, From + DISTANCE_ROW_TILE) };
+        for (std::size_t column{}; column < To; column += DISTANCE_COLUMN_TILE)
+            for (auto row{ std::max(From, column) }; row < To; ++row)
+                DistanceRow(
+                    metric,
+                    xs[row],
+                    ys[row],
+                    xs.data() + column,
+                    ys.data() + column,
+                    std::min(row, column + DISTANCE_COLUMN_TILE) - column,
+                    Data + row * (row + 1) / 2 + column);
+    } };
+
+    auto const Tiles{ (Count + DISTANCE_ROW_TILE - 1) / DISTANCE_ROW_TILE };
+    if (Tiles < 2)
+        for (std::size_t i{}; i < Tiles; ++i)
+            FillTile(i);
+    else
+    {
+        Executor executor{ options };
+        executor.ParallelFor(0, Tiles, FillTile);
+    }
+    return matrix;
+}
+
+// How the distances between the nodes are provided.
+enum class DistanceMode
+{
+    Matrix, // Every distance computed up front, O(n^2 / 2) memory
+    FloatMatrix, // The matrix as float, in half the memory
+    IntMatrix, // The matrix rounded to the nearest int32, as TSPLIB rounds
+    Implicit, // Computed from the coordinates when needed, O(n) memory
+    Cached, // Implicit behind a bounded cache
+    Mapped, // The matrix of a packed problem file, shared between processes
+    MappedFloat // Mapped, for files packed with a float matrix
+};
+
+inline DistanceMode ParseDistanceMode(char const* name) noexcept
+{
+    if (std::strcmp(name, "float") == 0)
+        return DistanceMode::FloatMatrix;
+    if (std::strcmp(name, "int") == 0)
+        return DistanceMode::IntMatrix;
+    if (std::strcmp(name, "implicit") == 0)
+        return DistanceMode::Implicit;
+    if (std::strcmp(name, "cached") == 0)
+        return DistanceMode::Cached;
+    if (std::strcmp(name, "mapped") == 0)
+        return DistanceMode::Mapped;
+    if (std::strcmp(name, "mappedfloat") == 0)
+        return DistanceMode::MappedFloat;
+    return DistanceMode::Matrix;
+}
+
+template<typename Graph>
+struct GraphTag
+{
+    using type = Graph;
+};
+
+// Call f with a GraphTag of the graph type used for mode.
+template<typename T, typename F>
+void WithDistanceMode(DistanceMode mode, F&& f)
+{
+    switch (mode)
+    {
+    case DistanceMode::FloatMatrix:
+        f(GraphTag<SymmetricMatrix<float>>{});
+        break;
+    case DistanceMode::IntMatrix:
+        f(GraphTag<SymmetricMatrix<std::int32_t>>{});
+        break;
+    case DistanceMode::Implicit:
+        f(GraphTag<EuclideanDistance<T>>{});
+        break;
+    case DistanceMode::Cached:
+        f(GraphTag<CachedDistance<EuclideanDistance<T>>>{});
+        break;
+    case DistanceMode::Mapped:
+        f(GraphTag<MappedMatrix<T>>{});
+        break;
+    case DistanceMode::MappedFloat:
+        f(GraphTag<MappedMatrix<float>>{});
+        break;
+    default:
+        f(GraphTag<SymmetricMatrix<T>>{});
+        break;
+    }
+}
+
+template<typename I>
+struct IndexTag
+{
+    using type = I;
+};
+
+// Call f with an IndexTag of the narrowest unsigned type that can hold the
+// city indices of a route of count cities.
+template<typename F>
+void WithRouteIndex(std::size_t count, F&& f)
+{
+    if (count <= std::size_t{std::numeric_limits<std::uint16_t>::max()} + 1)
+        f(IndexTag<std::uint16_t>{});
+    else if (count <= std::size_t{std::numeric_limits<std::uint32_t>::max()} + 1)
+        f(IndexTag<std::uint32_t>{});
+    else
+        f(IndexTag<std::size_t>{});
+}
+
+template<typename T, typename Graph = SymmetricMatrix<T>>
 class TravlingSalesman
 {
 public:
@@ -39,38 +401,109 @@ public:
         T y;
     };
 
-    explicit TravlingSalesman(char const* fileName);
+    // Read a CSV, TSPLIB or packed problem and build candidateCount nearest
+    // neighbours per node, none when zero. The matrix and candidate lists of
+    // a packed problem are used in place when they fit. Long files and
+    // matrices are handled on the threads of options.
+    explicit TravlingSalesman(
+        char const* fileName,
+        std::size_t candidateCount = 0,
+        ExecutorOptions const& options = ExecutorOptions::FromEnvironment());
+
+    // Build from nodes that were not read from a file.
+    explicit TravlingSalesman(
+        std::vector<NodeInfo> nodes,
+        std::size_t candidateCount = 0,
+        Metric metric = Metric::Euclidean,
+        ExecutorOptions const& options = ExecutorOptions::FromEnvironment());
 
     template<typename ForwardIt>
     std::ostream& Show(std::ostream& outs, ForwardIt first, ForwardIt);
 
-    constexpr AdjacencyMatrix<T>& Env() noexcept;
+    // Take the closed route [first, last) to a local optimum of the
+    // LinKernighan moves, as a last step after another search. Does nothing
+    // without candidate lists. Returns the cost of the route.
+    template<typename RandomIt>
+    auto Polish(RandomIt first, RandomIt last);
+
+    constexpr Graph& Env() noexcept;
 
     constexpr NodeInfo const* Nodes() const noexcept;
 
     constexpr NodeInfo const& Node(std::size_t id) const noexcept;
 
+    constexpr CandidateList const& Candidates() const noexcept;
+
+    constexpr Metric DistanceMetric() const noexcept;
+
 private:
     std::vector<NodeInfo> nodeIndex_;
 
-    AdjacencyMatrix<T> env_;
+    Metric metric_;
+
+    Graph env_;
+
+    CandidateList candidates_;
+
+    TravlingSalesman(
+        internal::ProblemData<NodeInfo> problem,
+        std::size_t candidateCount,
+        ExecutorOptions const& options);
 
     template<typename Container>
-    static inline AdjacencyMatrix<T> ReadGraphFromFile(
-        char const* fileName,
-        Container&& container);
+    static inline Graph BuildGraph(
+        Container const& container,
+        Metric metric,
+        std::optional<PackedProblem> const& packed,
+        ExecutorOptions const& options);
+
+    template<typename Container>
+    static inline CandidateList BuildCandidates(
+        Container const& container,
+        std::size_t candidateCount,
+        std::optional<PackedProblem> const& packed);
 };
 
-template<typename T>
-TravlingSalesman<T>::TravlingSalesman(char const* fileName)
-    : nodeIndex_{}
-    , env_{ReadGraphFromFile(fileName, nodeIndex_)}
+template<typename T, typename Graph>
+TravlingSalesman<T, Graph>::TravlingSalesman(
+    char const* fileName,
+    std::size_t candidateCount,
+    ExecutorOptions const& options)
+    : TravlingSalesman{
+        internal::ReadTravlingSalesmanData<NodeInfo>(fileName, options),
+        candidateCount,
+        options}
+{
+}
+
+template<typename T, typename Graph>
+TravlingSalesman<T, Graph>::TravlingSalesman(
+    internal::ProblemData<NodeInfo> problem,
+    std::size_t candidateCount,
+    ExecutorOptions const& options)
+    : nodeIndex_{std::move(problem.nodes)}
+    , metric_{problem.metric}
+    , env_{BuildGraph(nodeIndex_, metric_, problem.packed, options)}
+    , candidates_{BuildCandidates(nodeIndex_, candidateCount, problem.packed)}
+{
+}
+
+template<typename T, typename Graph>
+TravlingSalesman<T, Graph>::TravlingSalesman(
+    std::vector<NodeInfo> nodes,
+    std::size_t candidateCount,
+    Metric metric,
+    ExecutorOptions const& options)
+    : nodeIndex_{std::move(nodes)}
+    , metric_{metric}
+    , env_{BuildGraph(nodeIndex_, metric_, std::nullopt, options)}
+    , candidates_{BuildCandidates(nodeIndex_, candidateCount, std::nullopt)}
 {
 }
 
-template<typename T>
+template<typename T, typename Graph>
 template<typename ForwardIt>
-std::ostream& TravlingSalesman<T>::Show(
+std::ostream& TravlingSalesman<T, Graph>::Show(
     std::ostream& outs,
     ForwardIt first,
     ForwardIt last)
@@ -86,69 +519,102 @@ std::ostream& TravlingSalesman<T>::Show(
     return outs << "]\n";
 }
 
-template<typename T>
-constexpr AdjacencyMatrix<T>& TravlingSalesman<T>::Env() noexcept
+template<typename T, typename Graph>
+template<typename RandomIt>
+auto TravlingSalesman<T, Graph>::Polish(RandomIt first, RandomIt last)
+{
+    if (!candidates_.Empty())
+        ImproveRoute(env_, candidates_, first, last, LocalSearchMove::LinKernighan);
+    return CostOf(env_, first, last);
+}
+
+template<typename T, typename Graph>
+constexpr Graph& TravlingSalesman<T, Graph>::Env() noexcept
 {
     return env_;
 }
 
-template<typename T>
-constexpr typename TravlingSalesman<T>::NodeInfo const&
-TravlingSalesman<T>::Node(std::size_t id)
+template<typename T, typename Graph>
+constexpr typename TravlingSalesman<T, Graph>::NodeInfo const&
+TravlingSalesman<T, Graph>::Node(std::size_t id)
     const
     noexcept
 {
     return nodeIndex_[id];
 }
 
-template<typename T>
-constexpr typename TravlingSalesman<T>::NodeInfo const*
-TravlingSalesman<T>::Nodes()
+template<typename T, typename Graph>
+constexpr typename TravlingSalesman<T, Graph>::NodeInfo const*
+TravlingSalesman<T, Graph>::Nodes()
     const
     noexcept
 {
     return nodeIndex_.data();
 }
 
-template<typename T>
-template<typename Container>
-AdjacencyMatrix<T> TravlingSalesman<T>::ReadGraphFromFile(
-    char const* fileName,
-    Container&& container)
+template<typename T, typename Graph>
+constexpr CandidateList const& TravlingSalesman<T, Graph>::Candidates() const noexcept
 {
-    internal::ReadTravlingSalesmanData(
-        fileName,
-        std::back_inserter(container),
-        [](std::istream& ins, auto& node)
-        {
-            std::string line;
-            if (!(ins >> line))
-                return false;
-
-            auto first = line.begin();
-            auto last = std::find(first, line.end(), ',');
-            std::string name{ first, last };
-
-            first = last + 1;
-            last = std::find(first, line.end(), ',');
-            std::string x { first, last };
+    return candidates_;
+}
 
-            first = last + 1;
-            last = std::find(first, line.end(), ',');
-            std::string y { first, last };
+template<typename T, typename Graph>
+constexpr Metric TravlingSalesman<T, Graph>::DistanceMetric() const noexcept
+{
+    return metric_;
+}
 
-            node = NodeInfo{name, std::stod(x), std::stod(y)};
-            return true;
-        });
+template<typename T, typename Graph>
+template<typename Container>
+Graph TravlingSalesman<T, Graph>::BuildGraph(
+    Container const& container,
+    Metric metric,
+    std::optional<PackedProblem> const& packed,
+    ExecutorOptions const& options)
+{
+    using Value = typename Graph::value_type;
+    if constexpr (std::is_same_v<Graph, MappedMatrix<Value>>)
+    {
+        if (packed && packed->template Matrix<Value>() != nullptr)
+            return Graph{
+                packed->File(),
+                packed->template Matrix<Value>(),
+                packed->Count()};
+        std::cerr << "The problem has no packed "
+            << (std::is_same_v<Value, float> ? "float" : "double")
+            << " matrix, computing the distances instead\n";
+    }
 
-    AdjacencyMatrix<double> graph{ container.size() };
-    for (auto i = container.begin(); i != container.end(); ++i)
-        for (auto j = i + 1; j != container.end(); ++j)
-            graph(std::distance(container.begin(), i),
-                std::distance(container.begin(), j)) =
-            std::hypot(i->x - j->x, i->y - j->y);
+    // Distance providers only need the coordinates
+    if constexpr (std::is_same_v<Graph, SymmetricMatrix<Value>>)
+        return DistanceMatrix<Value>(
+            container.begin(),
+            container.end(),
+            metric,
+            options);
+    else if constexpr (std::is_constructible_v<Graph, SymmetricMatrix<Value>&&>)
+        return Graph{DistanceMatrix<Value>(
+            container.begin(),
+            container.end(),
+            metric,
+            options)};
+    else
+        return Graph{container.begin(), container.end(), metric};
+}
 
-    return graph;
+template<typename T, typename Graph>
+template<typename Container>
+CandidateList TravlingSalesman<T, Graph>::BuildCandidates(
+    Container const& container,
+    std::size_t candidateCount,
+    std::optional<PackedProblem> const& packed)
+{
+    auto const Size{ container.empty()
+        ? 0
+        : std::min(candidateCount, container.size() - 1) };
+    if (packed && Size != 0 && Size <= packed->CandidateCount())
+        return packed->Candidates(Size);
+    return CandidateList{container.begin(), container.end(), candidateCount};
 }
 
 #endif // !TRAVLINGSALESMAN_H_